@@ -0,0 +1,304 @@
+#include "BigFixed.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+const uint MIN_FRACTION_LIMBS = 2;
+const double LIMB_RANGE = 4294967296.0; // 2^32
+} // namespace
+
+BigFixed::BigFixed()
+    : m_negative(false), m_limbs(1 + MIN_FRACTION_LIMBS, 0u)
+{
+}
+
+BigFixed::BigFixed(double x)
+    : m_negative(x < 0.0), m_limbs(1, 0u)
+{
+    CORE_ASSERT(std::isfinite(x), "Can't represent " << x);
+    double a = std::abs(x);
+    CORE_ASSERT(a < LIMB_RANGE, "Integer part too large : " << x);
+
+    // Peel off 32 bits at a time. Every step is exact, since a double has at most 53 significant bits.
+    m_limbs[0] = static_cast<Limb>(std::floor(a));
+    a -= std::floor(a);
+    while (a != 0.0 || m_limbs.size() < 1 + MIN_FRACTION_LIMBS)
+    {
+        a *= LIMB_RANGE;
+        const double digit = std::floor(a);
+        m_limbs.push_back(static_cast<Limb>(digit));
+        a -= digit;
+    }
+    normalizeSign();
+}
+
+BigFixed::BigFixed(const FloatExp &x)
+    : m_negative(x.getMantissa() < 0.0), m_limbs(1 + MIN_FRACTION_LIMBS, 0u)
+{
+    CORE_ASSERT(std::isfinite(x.getMantissa()), "Can't represent " << x.toString());
+    CORE_ASSERT(x.getExponent() <= 32, "Integer part too large : " << x.toString());
+
+    // x = bits * 2^lowest, with a 53-bit integer
+    const uint64 bits = static_cast<uint64>(std::ldexp(std::abs(x.getMantissa()), 53));
+    const int64 lowest = x.getExponent() - 53;
+    if (lowest < 0)
+    {
+        m_limbs.resize(1 + std::max<int64>(MIN_FRACTION_LIMBS, (31 - lowest) / 32), 0u);
+    }
+    for (uint b = 0; b < 53; ++b)
+    {
+        if ((bits >> b) & 1)
+        {
+            // Bit of weight 2^w : bit w of the integer limb, or bit 32k - p of the fraction limb k with p = -w
+            const int64 w = lowest + b;
+            const int64 p = -w;
+            const int64 k = w >= 0 ? 0 : (p + 31) / 32;
+            m_limbs[k] |= Limb(1) << (w >= 0 ? w : 32 * k - p);
+        }
+    }
+    normalizeSign();
+}
+
+void BigFixed::setFractionLimbs(uint n)
+{
+    m_limbs.resize(1 + n, 0u);
+    normalizeSign();
+}
+
+uint BigFixed::limbsForScale(const FloatExp &scale, uint guardBits)
+{
+    const double bits = std::max(0.0, -scale.log2()) + guardBits;
+    return std::max(MIN_FRACTION_LIMBS, uint(std::ceil(bits / 32.0)));
+}
+
+double BigFixed::toDouble() const
+{
+    // Skip leading zero limbs, then add up three limbs (96 bits)
+    uint first = 0;
+    while (first < m_limbs.size() && m_limbs[first] == 0)
+    {
+        ++first;
+    }
+    double result = 0.0;
+    for (uint k = first; k < first + 3 && k < m_limbs.size(); ++k)
+    {
+        result += std::ldexp(static_cast<double>(m_limbs[k]), -32 * int(k));
+    }
+    return m_negative ? -result : result;
+}
+
+void BigFixed::normalizeSign()
+{
+    if (std::all_of(m_limbs.begin(), m_limbs.end(), [](Limb l) { return l == 0; }))
+    {
+        m_negative = false;
+    }
+}
+
+int BigFixed::compareMagnitude(const BigFixed &a, const BigFixed &b)
+{
+    const uint n = uint(std::max(a.m_limbs.size(), b.m_limbs.size()));
+    for (uint k = 0; k < n; ++k)
+    {
+        if (a.limb(k) != b.limb(k))
+        {
+            return a.limb(k) < b.limb(k) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+std::vector<BigFixed::Limb> BigFixed::addMagnitude(const BigFixed &a, const BigFixed &b, uint n)
+{
+    std::vector<Limb> result(n + 1);
+    uint64 carry = 0;
+    for (uint k = n + 1; k-- > 0;)
+    {
+        const uint64 sum = uint64(a.limb(k)) + uint64(b.limb(k)) + carry;
+        result[k] = static_cast<Limb>(sum);
+        carry = sum >> 32;
+    }
+    CORE_ASSERT(carry == 0, "BigFixed overflow");
+    return result;
+}
+
+std::vector<BigFixed::Limb> BigFixed::subMagnitude(const BigFixed &a, const BigFixed &b, uint n)
+{
+    std::vector<Limb> result(n + 1);
+    uint64 borrow = 0;
+    for (uint k = n + 1; k-- > 0;)
+    {
+        const uint64 sub = uint64(b.limb(k)) + borrow;
+        const uint64 ak = a.limb(k);
+        result[k] = static_cast<Limb>(ak - sub);
+        borrow = ak < sub ? 1 : 0;
+    }
+    CORE_ASSERT(borrow == 0, "BigFixed subtraction underflow");
+    return result;
+}
+
+BigFixed BigFixed::operator-() const
+{
+    BigFixed result(*this);
+    result.m_negative = !m_negative;
+    result.normalizeSign();
+    return result;
+}
+
+BigFixed BigFixed::operator+(const BigFixed &b) const
+{
+    const uint n = std::max(getFractionLimbs(), b.getFractionLimbs());
+    BigFixed result;
+    if (m_negative == b.m_negative)
+    {
+        result.m_limbs = addMagnitude(*this, b, n);
+        result.m_negative = m_negative;
+    }
+    else if (compareMagnitude(*this, b) >= 0)
+    {
+        result.m_limbs = subMagnitude(*this, b, n);
+        result.m_negative = m_negative;
+    }
+    else
+    {
+        result.m_limbs = subMagnitude(b, *this, n);
+        result.m_negative = b.m_negative;
+    }
+    result.normalizeSign();
+    return result;
+}
+
+BigFixed BigFixed::operator-(const BigFixed &b) const
+{
+    return *this + (-b);
+}
+
+BigFixed BigFixed::operator*(const BigFixed &b) const
+{
+    const uint n = std::max(getFractionLimbs(), b.getFractionLimbs());
+    const uint la = uint(m_limbs.size());
+    const uint lb = uint(b.m_limbs.size());
+
+    // Schoolbook product. Limb i of a times limb j of b has weight 2^(-32(i+j)) and goes to
+    // product[i+j+1] ; product[0] receives the carries above the integer part.
+    std::vector<Limb> product(la + lb, 0u);
+    for (uint i = la; i-- > 0;)
+    {
+        uint64 carry = 0;
+        for (uint j = lb; j-- > 0;)
+        {
+            const uint64 t = uint64(m_limbs[i]) * uint64(b.m_limbs[j]) + product[i + j + 1] + carry;
+            product[i + j + 1] = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+        product[i] = static_cast<Limb>(carry);
+    }
+    CORE_ASSERT(product[0] == 0, "BigFixed overflow");
+
+    BigFixed result;
+    result.m_limbs.assign(product.begin() + 1, product.begin() + 1 + std::min<uint>(n + 1, la + lb - 1));
+    result.m_limbs.resize(n + 1, 0u);
+    result.m_negative = m_negative != b.m_negative;
+    result.normalizeSign();
+    return result;
+}
+
+bool BigFixed::operator==(const BigFixed &b) const
+{
+    return m_negative == b.m_negative && compareMagnitude(*this, b) == 0;
+}
+
+std::string BigFixed::toHexString() const
+{
+    std::string result = m_negative ? "-" : "";
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%x.", static_cast<unsigned>(m_limbs[0]));
+    result += buffer;
+    for (uint k = 1; k < m_limbs.size(); ++k)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%08x", static_cast<unsigned>(m_limbs[k]));
+        result += buffer;
+    }
+    return result;
+}
+
+BigFixed BigFixed::fromHexString(const std::string &str)
+{
+    const bool negative = !str.empty() && str[0] == '-';
+    const size_t start = negative ? 1 : 0;
+    const size_t dot = str.find('.');
+    CORE_ASSERT(dot != std::string::npos && dot > start, "Invalid number " << str);
+    CORE_ASSERT((str.size() - dot - 1) % 8 == 0, "Invalid number " << str);
+
+    BigFixed result;
+    result.m_limbs.assign(1, static_cast<Limb>(std::stoul(str.substr(start, dot - start), nullptr, 16)));
+    for (size_t pos = dot + 1; pos < str.size(); pos += 8)
+    {
+        result.m_limbs.push_back(static_cast<Limb>(std::stoul(str.substr(pos, 8), nullptr, 16)));
+    }
+    result.m_limbs.resize(std::max<size_t>(result.m_limbs.size(), 1 + MIN_FRACTION_LIMBS), 0u);
+    result.m_negative = negative;
+    result.normalizeSign();
+    return result;
+}
+
+std::string BigFixed::toDecimalString(uint digits) const
+{
+    std::string result = m_negative ? "-" : "";
+    result += std::to_string(m_limbs[0]);
+    result += ".";
+
+    // Multiply the fraction by 10 and take the carry as the next digit
+    std::vector<Limb> fraction(m_limbs.begin() + 1, m_limbs.end());
+    for (uint d = 0; d < digits; ++d)
+    {
+        uint64 carry = 0;
+        for (uint k = uint(fraction.size()); k-- > 0;)
+        {
+            const uint64 t = uint64(fraction[k]) * 10 + carry;
+            fraction[k] = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+        result += static_cast<char>('0' + carry);
+    }
+    return result;
+}
+
+BigFixed BigFixed::fromDecimalString(const std::string &str)
+{
+    const bool negative = !str.empty() && str[0] == '-';
+    const size_t start = (negative || (!str.empty() && str[0] == '+')) ? 1 : 0;
+    const size_t dot = std::min(str.find('.'), str.size());
+    const std::string integer = str.substr(start, dot - start);
+    const std::string fraction = dot < str.size() ? str.substr(dot + 1) : std::string();
+
+    CORE_ASSERT(!integer.empty() || !fraction.empty(), "Invalid number " << str);
+    CORE_ASSERT(std::all_of(integer.begin(), integer.end(), ::isdigit) &&
+                    std::all_of(fraction.begin(), fraction.end(), ::isdigit),
+                "Invalid number " << str);
+
+    // log2(10) < 3.33 bits per digit, plus a guard limb
+    const uint n = std::max(MIN_FRACTION_LIMBS, uint(fraction.size() * 3.33 / 32.0) + 2);
+
+    // Horner scheme from the last digit : f = (f + d) / 10
+    BigFixed result;
+    result.m_limbs.assign(n + 1, 0u);
+    for (size_t i = fraction.size(); i-- > 0;)
+    {
+        result.m_limbs[0] += static_cast<Limb>(fraction[i] - '0');
+        uint64 remainder = 0;
+        for (uint k = 0; k <= n; ++k)
+        {
+            const uint64 t = (remainder << 32) | result.m_limbs[k];
+            result.m_limbs[k] = static_cast<Limb>(t / 10);
+            remainder = t % 10;
+        }
+    }
+    result.m_limbs[0] = integer.empty() ? 0u : static_cast<Limb>(std::stoul(integer));
+    result.m_negative = negative;
+    result.normalizeSign();
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef BIGFIXED_HPP_
+#define BIGFIXED_HPP_
+
+#include <CoreMacros.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FloatExp.hpp"
+
+/// Arbitrary precision signed fixed-point number, used for deep zoom coordinates.
+/// The magnitude is stored as base 2^32 limbs, most significant first : limb 0 is the
+/// integer part (so |x| < 2^32), limbs 1..n are the fraction. The number of fraction limbs
+/// (the precision) is chosen at runtime.
+class BigFixed
+{
+  public:
+    typedef std::uint32_t Limb;
+
+    /// Zero, with 2 fraction limbs
+    BigFixed();
+
+    /// Exact conversion from a double (uses as many limbs as needed, at least 2)
+    BigFixed(double x);
+
+    /// Exact conversion from a FloatExp, however small (uses as many limbs as needed, at least 2)
+    explicit BigFixed(const FloatExp &x);
+
+    /// Number of 32-bit fraction limbs
+    uint getFractionLimbs() const { return uint(m_limbs.size() - 1); }
+
+    /// Change the number of fraction limbs, truncating or padding with zeros
+    void setFractionLimbs(uint n);
+
+    /// Number of fraction limbs to resolve details of the given size with a safety margin
+    static uint limbsForScale(const FloatExp &scale, uint guardBits = 64);
+
+    /// Nearest double (truncated after 96 significant bits)
+    double toDouble() const;
+
+    bool isNegative() const { return m_negative; }
+
+    /// Limb k of the magnitude (0 = integer part), 0 past the precision
+    Limb getLimb(uint k) const { return limb(k); }
+
+    // Arithmetic. The result has the precision of the most precise operand.
+    BigFixed operator-() const;
+    BigFixed operator+(const BigFixed &b) const;
+    BigFixed operator-(const BigFixed &b) const;
+    BigFixed operator*(const BigFixed &b) const;
+    BigFixed &operator+=(const BigFixed &b) { return *this = *this + b; }
+    BigFixed &operator-=(const BigFixed &b) { return *this = *this - b; }
+
+    bool operator==(const BigFixed &b) const;
+    bool operator!=(const BigFixed &b) const { return !(*this == b); }
+
+    /// Exact text representation, e.g. "-0.8000000000000000" (hexadecimal limbs)
+    std::string toHexString() const;
+    static BigFixed fromHexString(const std::string &str);
+
+    /// Decimal representation with the given number of fraction digits
+    std::string toDecimalString(uint digits) const;
+
+    /// Parse a decimal number such as "-0.74364388703715870475219150611477"
+    /// with enough precision for all its digits.
+    static BigFixed fromDecimalString(const std::string &str);
+
+  private:
+    /// Compare magnitudes : -1, 0 or 1
+    static int compareMagnitude(const BigFixed &a, const BigFixed &b);
+
+    /// Add or subtract magnitudes (|a| >= |b| for the subtraction), with n fraction limbs
+    static std::vector<Limb> addMagnitude(const BigFixed &a, const BigFixed &b, uint n);
+    static std::vector<Limb> subMagnitude(const BigFixed &a, const BigFixed &b, uint n);
+
+    /// Limb k of the magnitude, 0 past the precision
+    Limb limb(uint k) const { return k < m_limbs.size() ? m_limbs[k] : 0u; }
+
+    /// Make zero positive
+    void normalizeSign();
+
+  private:
+    bool m_negative;
+    std::vector<Limb> m_limbs;
+};
+
+#endif // BIGFIXED_HPP_
@@ -0,0 +1,29 @@
+# Build check of the vectorized kernels (SimdKernels.hpp) : the objects with functions compiled for
+# an instruction set must not define shared symbols holding instructions of that set. The inline
+# functions and templates are emitted as weak symbols in each object that uses them, and the linker
+# keeps any one of the copies : a copy with AVX instructions would then run on every CPU.
+# Run after the build by CMakeLists.txt :
+#   cmake -DNM=<nm> -DOBJDUMP=<objdump> -DOBJECTS=<objects> -P CheckIsaObjects.cmake
+
+foreach (object ${OBJECTS})
+    execute_process(COMMAND "${NM}" --defined-only "${object}"
+            OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${NM} failed on ${object}")
+    endif()
+
+    # Weak (W, V) and unique (u) symbols are the ones shared between objects
+    string(REGEX MATCHALL "[^\n]* [WVu] [^\n]*" weakSymbols "${symbols}")
+    foreach (line ${weakSymbols})
+        string(REGEX REPLACE ".* [WVu] " "" symbol "${line}")
+        execute_process(COMMAND "${OBJDUMP}" -d --no-show-raw-insn "--disassemble=${symbol}" "${object}"
+                OUTPUT_VARIABLE code RESULT_VARIABLE result)
+        if (NOT result EQUAL 0)
+            message(FATAL_ERROR "${OBJDUMP} failed on ${object}")
+        endif()
+        # VEX and EVEX instructions (AVX, FMA, AVX-512) are the ones starting with v, or k for the masks
+        if (code MATCHES ":\t+([vk][a-z0-9]+) ")
+            message(FATAL_ERROR "${object} : shared symbol ${symbol} holds vector instructions (${CMAKE_MATCH_1})")
+        endif()
+    endforeach()
+endforeach()
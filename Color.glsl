@@ -0,0 +1,46 @@
+#version 420 core
+#include <ColorSchemes.glsl>
+
+// Second pass : coloring of the iteration field, written by the Pixel*.glsl shaders or uploaded
+// by the CPU renderer. The field is only computed again when the view changes, so this pass
+// alone runs when only the colors change.
+
+in vec2 pos;
+out vec4 FragColor;
+
+uniform sampler2D field; // iteration at escape (max for points in the set) and |z|^2
+uniform uint max = 1000u;
+
+// Palette (see Palette.hpp) : layer paletteIndex of the palettes, of paletteSize colors. The period
+// is already resolved to the max iterations if needed.
+uniform sampler1DArray palettes;
+uniform int paletteIndex = 0;
+uniform int paletteSize = 1;
+uniform float paletteLog = 0.0;
+uniform float palettePeriod = 1.0;
+uniform float paletteOffset = 0.0;
+
+// Histogram equalization : the palette spans the cumulative histogram of the frame once, instead
+// of its period. A uniform, so the branch is the same for all the pixels.
+uniform bool equalize = false;
+uniform samplerBuffer cdf;
+
+void main()
+{
+    vec2 value = texelFetch(field, ivec2(gl_FragCoord.xy), 0).xy;
+    uint iters = uint(value.x);
+    if (iters >= max)
+    {
+        FragColor = vec4(0,0,0,0);
+    }
+    else if (equalize)
+    {
+        float x = equalizedCoordinate(cdf, max, iters, value.y);
+        FragColor = paletteSample(palettes, paletteIndex, paletteSize, x + paletteOffset);
+    }
+    else
+    {
+        FragColor = paletteColor(palettes, paletteIndex, paletteSize, paletteLog, palettePeriod, paletteOffset,
+                                 iters, value.y);
+    }
+}
@@ -1,47 +1,43 @@
 // Common code for coloring mandelbrot
-// A collection of colorschemes I picked up from other sources
+// Colors come from a palette (see Palette.hpp) : a cycle of colors baked from a color scheme, or
+// loaded from a file, indexed by the smooth iteration count. All the palettes are layers of one
+// texture array : the palette is picked by a uniform layer index, without shader variants or branches.
 
-//Change color from HSV to RGB.
-vec4 HSVtoRGBA(vec3 hsv)
+// Smooth iteration count of an escaped point : n + 1 - log2(log2 |z|), with radius = |z|^2
+float smoothIteration(uint iters, float radius)
 {
-    //Algorithm from https://gist.github.com/patriciogonzalezvivo/114c1653de9e3da6e1e3
-	vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);
-	vec3 m = abs(fract(hsv.xxx + K.xyz) * 6.0 - K.www);
-	return  vec4(hsv.z * mix(K.xxx, clamp(m - K.xxx, 0.0, 1.0), hsv.y),1.0);
+    return float(iters) + 1.0 - log2(0.5 * log2(radius));
 }
 
-
-vec4 blueYellow( uint iters, uint maxiters, float radius, float maxi)
+// Color at `x` cycles of a palette, the first `size` colors of layer `layer` (the layers are as
+// wide as the largest palette). The colors are interpolated linearly, as in paletteSample() on the CPU.
+vec4 paletteSample(sampler1DArray palettes, int layer, int size, float x)
 {
-	float speed = float(iters)/float(maxiters);
-	return vec4 ( speed, speed, 0.5, 1.0 );
+    float t = fract(x) * float(size);
+    int k = min(int(t), size - 1);
+    vec4 a = texelFetch(palettes, ivec2(k, layer), 0);
+    vec4 b = texelFetch(palettes, ivec2((k + 1) % size, layer), 0);
+    return a + (b - a) * (t - float(k));
 }
 
-vec4 flashyColor( uint iters, uint maxiters, float radius, float maxi )
+// Color of an escaped point. The palette coordinate is the smooth iteration count, or its log
+// if logarithmic = 1 : the palette repeats every `period` units of it, shifted by `offset` cycles.
+vec4 paletteColor(sampler1DArray palettes, int layer, int size, float logarithmic, float period, float offset,
+                  uint iters, float radius)
 {
-	const float log2 = log(2.0);
-	// colorRegulator increases linearly by 1 for every extra step it takes to break free.
-	float colorRegulator = float(iters-1u)-log(((log(radius))/log2)/log2);
-	//This is a coloring algorithm I found to be appealing. Written in HSV, many functions will work.
-	vec3  hsv = vec3(0.95 + .012*colorRegulator , 1.0, .2+.4*(1.0+sin(.3*colorRegulator)));
-	return HSVtoRGBA(hsv);
+    float mu = smoothIteration(iters, radius);
+    float x = mu * (1.0 - logarithmic) + log(max(mu, 1e-3)) * logarithmic;
+    return paletteSample(palettes, layer, size, x / period + offset);
 }
 
-vec4 softColor( uint iters, uint maxiters, float radius, float maxi)
+// Histogram equalization : fraction of the escaped pixels of the frame whose smooth iteration count
+// is below this one's. cdf[k] is the fraction of them that escaped before iteration k, for k in
+// [0, max], computed on the CPU from the iteration field (see equalizedCoordinate() on the CPU).
+float equalizedCoordinate(samplerBuffer cdf, uint max, uint iters, float radius)
 {
-
-	const float log2 = log(2.0);
-    float colorRegulator = 1. - log( 0.5*log(radius) / log2 ) / log2;
-	float speed2 = log(iters+ colorRegulator);
-	vec3 hsv = vec3(speed2, 0.4, 1.);
-	return HSVtoRGBA(hsv);
+    float mu = clamp(smoothIteration(iters, radius), 0.0, float(max));
+    int k = min(int(mu), int(max) - 1);
+    float a = texelFetch(cdf, k).x;
+    float b = texelFetch(cdf, k + 1).x;
+    return a + (b - a) * (mu - float(k));
 }
-
-vec4 colorScheme( uint iters, uint maxiters, float radius, float maxi)
-{
-	//return flashyColor(iters, maxiters, radius, maxi);
-	//return blueYellow(iters,maxiters,radius,maxi);
-	return softColor(iters,maxiters,radius,maxi);
-}
-
-
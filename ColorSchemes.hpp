@@ -0,0 +1,54 @@
+#ifndef COLORSCHEMES_HPP_
+#define COLORSCHEMES_HPP_
+
+// CPU port of ColorSchemes.glsl (with Palette.hpp). Keep both files in sync so that CPU and GL renders match.
+
+#include <CoreMacros.hpp>
+#include <cmath>
+#include <algorithm>
+
+/// RGBA color with float channels, equivalent of a GLSL vec4
+struct Rgba
+{
+    float r, g, b, a;
+};
+
+/// GLSL fract()
+inline float glsl_fract(float x)
+{
+    return x - std::floor(x);
+}
+
+/// Change color from HSV to RGB.
+inline Rgba HSVtoRGBA(float h, float s, float v)
+{
+    //Algorithm from https://gist.github.com/patriciogonzalezvivo/114c1653de9e3da6e1e3
+    const float K[4] = {1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 3.0f};
+    float rgb[3];
+    for (uint i = 0; i < 3; ++i)
+    {
+        const float m = std::abs(glsl_fract(h + K[i]) * 6.0f - K[3]);
+        const float c = std::min(std::max(m - K[0], 0.0f), 1.0f);
+        rgb[i] = v * (K[0] * (1.0f - s) + c * s); // mix(K.x, c, s)
+    }
+    return Rgba{rgb[0], rgb[1], rgb[2], 1.0f};
+}
+
+/// Smooth iteration count of an escaped point : n + 1 - log2(log2 |z|), with radius = |z|^2
+inline float smoothIteration(uint iters, float radius)
+{
+    return float(iters) + 1.0f - std::log2(0.5f * std::log2(radius));
+}
+
+/// Convert a float channel to 8 bits the way GL does when writing to a RGBA8 framebuffer.
+/// NaNs are written as 0.
+inline uchar toUnorm8(float c)
+{
+    if (!(c > 0.f))
+    {
+        return 0;
+    }
+    return static_cast<uchar>(std::lround(std::min(c, 1.f) * 255.f));
+}
+
+#endif // COLORSCHEMES_HPP_
@@ -0,0 +1,751 @@
+#include "CpuRenderer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include "EscapeKernels.hpp"
+#include "SimdKernels.hpp"
+#include "InteriorDistance.hpp"
+#include "Perturbation.hpp"
+#include "Palette.hpp"
+
+// Everything the tiles need to know about the frame being rendered. Kept from one call to the next :
+// renderRects() calls on the same view and shader reuse it, e.g. the perturbation reference.
+struct CpuRenderer::RenderJob
+{
+    View view;
+    ShaderType shader;
+    IterationField *field;                          // field being rendered, set by each call
+    ComplexDD ddCenter;                             // DoubleDouble only
+    QuadFloat qfCenter[2];                          // QuadFloat only
+    std::unique_ptr<ReferenceOrbit> reference;      // Perturbation only
+    std::unique_ptr<BlaTable> bla;                  // Perturbation only, if enabled
+    std::unique_ptr<SeriesApproximation> series;    // Perturbation only, if enabled
+    std::vector<uint> seriesSkip;                   // Iterations skipped by the series, per tile
+    PerturbationReference primary;                  // The above, as used by the pixels
+};
+
+CpuRenderer::CpuRenderer(uint threads)
+    : m_scheduler(threads),
+      m_simdIsa(detectSimdIsa()),
+      m_renderMode(RENDER_FULL)
+{
+}
+
+// Rectangles computed in the background, from startRects() to finishRects() or cancelRects()
+struct CpuRenderer::AsyncRects
+{
+    std::vector<PixelRect> tasks;       // tiles to compute, as cut by prepareRects()
+    std::mutex mutex;                   // guards `finished`
+    std::vector<PixelRect> finished;    // tiles done, not handed back yet
+    std::atomic<bool> cancelled{false}; // the tiles not started yet are skipped
+};
+
+CpuRenderer::~CpuRenderer()
+{
+    // The workers must not use the job any more
+    std::vector<PixelRect> finished;
+    cancelRects(finished);
+}
+
+void CpuRenderer::setSimdIsa(SimdIsa isa)
+{
+    CORE_ASSERT(isa <= detectSimdIsa(), "Instruction set not supported : " << simdIsaName(isa));
+    m_simdIsa = isa;
+}
+
+void CpuRenderer::setRenderMode(RenderMode mode)
+{
+    m_renderMode = mode;
+}
+
+void CpuRenderer::computeRow(const RenderJob &job, uint row, uint col, uint count, EscapeResult *results) const
+{
+    const View &view = job.view;
+    CORE_ASSERT(count <= TILE_SIZE, "Row segment too long");
+    float posX[TILE_SIZE];
+    for (uint i = 0; i < count; ++i)
+    {
+        posX[i] = pixelPosition(col + i, view.width, view.originX);
+    }
+
+    // The field is stored top to bottom, GL pixels are numbered bottom to top.
+    const float posY = pixelPosition(view.height - 1 - row, view.height, view.originY);
+    switch (job.shader)
+    {
+    case SHADER_FLOAT:
+        for (uint i = 0; i < count; ++i)
+        {
+            results[i] = escapeFloat(posX[i], posY, view);
+        }
+        break;
+    case SHADER_FLOATFLOAT:
+        escapeFloatFloatRow(m_simdIsa, posX, posY, count, view, results);
+        break;
+    case SHADER_DOUBLE:
+        escapeDoubleRow(m_simdIsa, posX, posY, count, view, results);
+        break;
+    case SHADER_QUADFLOAT:
+        for (uint i = 0; i < count; ++i)
+        {
+            results[i] = escapeQuadFloat(posX[i], posY, view, job.qfCenter);
+        }
+        break;
+    case SHADER_DOUBLEDOUBLE:
+        escapeDoubleDoubleRow(m_simdIsa, posX, posY, count, view, job.ddCenter, results);
+        break;
+    case SHADER_PERTURBATION:
+    {
+        const uint tilesX = (view.width + TILE_SIZE - 1) / TILE_SIZE;
+        const uint skip = job.series ? job.seriesSkip[(row / TILE_SIZE) * tilesX + col / TILE_SIZE] : 1;
+        for (uint i = 0; i < count; ++i)
+        {
+            results[i] = escapePerturbation(posX[i], posY, view, job.primary, skip);
+        }
+        break;
+    }
+    default:
+        CORE_ASSERT(false, "should not get here");
+    }
+}
+
+void CpuRenderer::renderTile(const RenderJob &job, const PixelRect &tile) const
+{
+    const View &view = job.view;
+    IterationField &field = *job.field;
+    const uint x0 = tile.x0;
+    const uint y0 = tile.y0;
+    const uint x1 = tile.x1;
+    const uint y1 = tile.y1;
+
+    if (m_renderMode != RENDER_FULL)
+    {
+        subdivideTile(job, x0, y0, x1, y1);
+        return;
+    }
+
+    EscapeResult results[TILE_SIZE];
+    for (uint row = y0; row < y1; ++row)
+    {
+        computeRow(job, row, x0, x1 - x0, results);
+        for (uint i = 0; i < x1 - x0; ++i)
+        {
+            const uint index = row * view.width + x0 + i;
+            field.iters[index] = results[i].iters;
+            field.norms[index] = results[i].norm;
+        }
+    }
+}
+
+// Mariani-Silver subdivision : compute the border of a rectangle. If all border pixels
+// have the same iteration count, fill the inside with it, otherwise split the rectangle
+// in two and start again on both halves.
+//
+// In strict mode, a uniform border is not enough : escaping filaments thinner than a pixel can
+// cross it between two samples. A rectangle is only filled when its border is in the set and
+// the interior distance estimate of every border pixel proves that a disk around it, reaching
+// the middle of the rectangle, is in the set too. Filled pixels are then provably in the set,
+// as the brute-force render would find them.
+void CpuRenderer::subdivideTile(const RenderJob &job, uint x0, uint y0, uint x1, uint y1) const
+{
+    const View &view = job.view;
+    IterationField &field = *job.field;
+
+    // Pixels already computed in the tile, so that borders shared by two rectangles are computed once
+    bool computed[TILE_SIZE * TILE_SIZE] = {};
+
+    // Strict mode : interior distance estimates of the border pixels, computed on demand (-1 = unknown)
+    double distances[TILE_SIZE * TILE_SIZE];
+    std::fill(distances, distances + TILE_SIZE * TILE_SIZE, -1.0);
+    const double pixelX = pixelWidth(view, view.scale);
+    const double pixelY = pixelHeight(view, view.scale);
+    const double pixelSize = std::max(pixelX, pixelY);
+
+    // True if the interior distance estimate of the pixel proves that a disk of the given radius is in the set
+    auto provenInside = [&](uint row, uint col, double radius) {
+        double &d = distances[(row - y0) * TILE_SIZE + (col - x0)];
+        if (d < 0.0)
+        {
+            const float posX = pixelPosition(col, view.width, view.originX);
+            const float posY = pixelPosition(view.height - 1 - row, view.height, view.originY);
+            if (job.reference && !isDeepZoom(view))
+            {
+                // Perturbation : c = reference + dc, only dc is rounded, so the rounding error scales with the view
+                double dcx, dcy;
+                pixelDelta(posX, posY, view, dcx, dcy);
+                d = perturbationInteriorDistance(dcx, dcy, view.iters, *job.reference) -
+                    4.0 * DBL_EPSILON * (std::abs(dcx) + std::abs(dcy));
+            }
+            else if (job.reference)
+            {
+                d = 0.0; // The deltas are beyond the double range : nothing is proven
+            }
+            else
+            {
+                // c is only known to double precision, so the disk must cover its rounding error too : past
+                // zooms of about 1e-15, no rectangle is proven inside
+                const double cx = static_cast<double>(posX) * pixelX + view.centerX;
+                const double cy = static_cast<double>(posY) * pixelY + view.centerY;
+                d = interiorDistance(cx, cy, view.iters) - 4.0 * DBL_EPSILON * (std::abs(cx) + std::abs(cy));
+            }
+        }
+        return 0.25 * d > radius;
+    };
+    EscapeResult results[TILE_SIZE];
+
+    // Compute the pixels [c0,c1) of a row
+    auto computeSpan = [&](uint row, uint c0, uint c1) {
+        computeRow(job, row, c0, c1 - c0, results);
+        for (uint c = c0; c < c1; ++c)
+        {
+            const uint index = row * view.width + c;
+            field.iters[index] = results[c - c0].iters;
+            field.norms[index] = results[c - c0].norm;
+            computed[(row - y0) * TILE_SIZE + (c - x0)] = true;
+        }
+    };
+    // Compute the pixels of [c0,c1) on a row that are not known yet, by runs to use the SIMD kernels
+    auto computeUnknown = [&](uint row, uint c0, uint c1) {
+        const bool *known = computed + (row - y0) * TILE_SIZE - x0;
+        uint c = c0;
+        while (c < c1)
+        {
+            if (known[c])
+            {
+                ++c;
+                continue;
+            }
+            uint end = c + 1;
+            while (end < c1 && !known[end])
+            {
+                ++end;
+            }
+            computeSpan(row, c, end);
+            c = end;
+        }
+    };
+
+    // Rectangles still to process, as half-open pixel ranges
+    struct Rect
+    {
+        uint x0, y0, x1, y1;
+    };
+    std::vector<Rect> stack;
+    stack.push_back(Rect{x0, y0, x1, y1});
+
+    while (!stack.empty())
+    {
+        const Rect r = stack.back();
+        stack.pop_back();
+
+        // Small rectangles are cheaper to compute directly
+        if (r.x1 - r.x0 <= 4 || r.y1 - r.y0 <= 4)
+        {
+            for (uint row = r.y0; row < r.y1; ++row)
+            {
+                computeUnknown(row, r.x0, r.x1);
+            }
+            continue;
+        }
+
+        // Border : top and bottom rows, then left and right columns
+        computeUnknown(r.y0, r.x0, r.x1);
+        computeUnknown(r.y1 - 1, r.x0, r.x1);
+        for (uint row = r.y0 + 1; row + 1 < r.y1; ++row)
+        {
+            computeUnknown(row, r.x0, r.x0 + 1);
+            computeUnknown(row, r.x1 - 1, r.x1);
+        }
+
+        const uint first = r.y0 * view.width + r.x0;
+        const uint value = field.iters[first];
+        bool uniform = (m_renderMode != RENDER_SUBDIVIDE_STRICT || value == view.iters);
+        for (uint col = r.x0; col < r.x1 && uniform; ++col)
+        {
+            uniform = field.iters[r.y0 * view.width + col] == value && field.iters[(r.y1 - 1) * view.width + col] == value;
+        }
+        for (uint row = r.y0 + 1; row + 1 < r.y1 && uniform; ++row)
+        {
+            uniform = field.iters[row * view.width + r.x0] == value && field.iters[row * view.width + r.x1 - 1] == value;
+        }
+
+        if (uniform && m_renderMode == RENDER_SUBDIVIDE_STRICT)
+        {
+            // Every pixel of the rectangle is on a row or column ending on the border, at most
+            // `reach` pixels away from it. Keep a 1% margin for rounding in the estimate.
+            const uint reach = (std::min(r.x1 - r.x0, r.y1 - r.y0) - 1) / 2;
+            const double radius = 1.01 * reach * pixelSize;
+            for (uint col = r.x0; col < r.x1 && uniform; ++col)
+            {
+                uniform = provenInside(r.y0, col, radius) && provenInside(r.y1 - 1, col, radius);
+            }
+            for (uint row = r.y0 + 1; row + 1 < r.y1 && uniform; ++row)
+            {
+                uniform = provenInside(row, r.x0, radius) && provenInside(row, r.x1 - 1, radius);
+            }
+        }
+
+        if (uniform)
+        {
+            const float norm = field.norms[first];
+            for (uint row = r.y0 + 1; row + 1 < r.y1; ++row)
+            {
+                for (uint col = r.x0 + 1; col + 1 < r.x1; ++col)
+                {
+                    field.iters[row * view.width + col] = value;
+                    field.norms[row * view.width + col] = norm;
+                    computed[(row - y0) * TILE_SIZE + (col - x0)] = true;
+                }
+            }
+        }
+        else if (r.x1 - r.x0 >= r.y1 - r.y0)
+        {
+            const uint mid = (r.x0 + r.x1) / 2;
+            stack.push_back(Rect{r.x0, r.y0, mid + 1, r.y1});
+            stack.push_back(Rect{mid, r.y0, r.x1, r.y1});
+        }
+        else
+        {
+            const uint mid = (r.y0 + r.y1) / 2;
+            stack.push_back(Rect{r.x0, r.y0, r.x1, mid + 1});
+            stack.push_back(Rect{r.x0, mid, r.x1, r.y1});
+        }
+    }
+}
+
+void CpuRenderer::render(const View &view, ShaderType shader, IterationField &field) const
+{
+    field.resize(view.width, view.height, view.iters);
+    renderRects(view, shader, field, {PixelRect{0, 0, view.width, view.height}});
+}
+
+void CpuRenderer::prepareJob(RenderJob &job) const
+{
+    const View &view = job.view;
+    const ShaderType shader = job.shader;
+    const uint tilesX = (view.width + TILE_SIZE - 1) / TILE_SIZE;
+    const uint tilesY = (view.height + TILE_SIZE - 1) / TILE_SIZE;
+    const uint tileCount = tilesX * tilesY;
+
+    if (shader == SHADER_QUADFLOAT)
+    {
+        job.qfCenter[0] = QuadFloat(view.preciseCenterX);
+        job.qfCenter[1] = QuadFloat(view.preciseCenterY);
+    }
+    if (shader == SHADER_DOUBLEDOUBLE)
+    {
+        // The center, rounded to a double, then the remainder
+        const double cx = view.preciseCenterX.toDouble();
+        const double cy = view.preciseCenterY.toDouble();
+        job.ddCenter = ComplexDD{DoubleDouble(cx, (view.preciseCenterX - BigFixed(cx)).toDouble()),
+                               DoubleDouble(cy, (view.preciseCenterY - BigFixed(cy)).toDouble())};
+    }
+    if (shader == SHADER_PERTURBATION)
+    {
+        // The reference orbit and the series are computed once per frame, then shared by all tiles
+        const uint limbs = BigFixed::limbsForScale(view.preciseScale);
+        job.primary.unit = deltaUnit(view);
+        job.reference.reset(new ReferenceOrbit(view.preciseCenterX, view.preciseCenterY, view.iters, limbs));
+        if (view.bilinearApproximation)
+        {
+            // Corner of the image farthest from the reference, at the center point
+            double cornerX, cornerY;
+            pixelDelta(static_cast<float>(std::abs(view.originX)) + 0.5f * static_cast<float>(view.width),
+                       static_cast<float>(std::abs(view.originY)) + 0.5f * static_cast<float>(view.height), view,
+                       cornerX, cornerY);
+            job.bla.reset(new BlaTable(*job.reference, FloatExp(std::hypot(cornerX, cornerY)) * job.primary.unit));
+        }
+        if (view.seriesTerms > 0)
+        {
+            // Probes at the tile corners, on the pixel boundaries
+            std::vector<double> probeX, probeY;
+            for (uint ty = 0; ty <= tilesY; ++ty)
+            {
+                for (uint tx = 0; tx <= tilesX; ++tx)
+                {
+                    const uint x = std::min(view.width, tx * TILE_SIZE);
+                    const uint y = view.height - std::min(view.height, ty * TILE_SIZE); // GL rows go up
+                    double dcx, dcy;
+                    pixelDelta(axisPosition(static_cast<float>(x), view.width, view.originX),
+                               axisPosition(static_cast<float>(y), view.height, view.originY), view, dcx, dcy);
+                    probeX.push_back(dcx);
+                    probeY.push_back(dcy);
+                }
+            }
+            const double pixelSize = 2.0 * (isDeepZoom(view) ? 1.0 : view.scale) / view.height; // in delta units
+            job.series.reset(new SeriesApproximation(*job.reference, view.seriesTerms, view.iters, pixelSize, probeX,
+                                                     probeY, job.primary.unit));
+
+            // A tile skips the iterations valid at its 4 corners
+            job.seriesSkip.resize(tileCount);
+            for (uint tile = 0; tile < tileCount; ++tile)
+            {
+                const uint p = (tile / tilesX) * (tilesX + 1) + tile % tilesX;
+                job.seriesSkip[tile] = std::min({job.series->getValidIterations(p),
+                                                 job.series->getValidIterations(p + 1),
+                                                 job.series->getValidIterations(p + tilesX + 1),
+                                                 job.series->getValidIterations(p + tilesX + 2)});
+            }
+        }
+    }
+
+    job.primary.orbit = job.reference.get();
+    job.primary.bla = job.bla.get();
+    job.primary.series = job.series.get();
+}
+
+std::vector<PixelRect> CpuRenderer::prepareRects(const View &view, ShaderType shader, IterationField &field,
+                                                 const std::vector<PixelRect> &rects) const
+{
+    CORE_ASSERT(shader < MAX_SHADERS, "Invalid shader");
+    CORE_ASSERT(field.width == view.width && field.height == view.height && field.maxIters == view.iters,
+                "Field and view mismatch");
+
+    const uint tilesX = (view.width + TILE_SIZE - 1) / TILE_SIZE;
+
+    if (!m_job || !(m_job->view == view) || m_job->shader != shader)
+    {
+        m_job.reset(new RenderJob{view, shader, nullptr, {}, {}, nullptr, nullptr, nullptr, {}, {}});
+        prepareJob(*m_job);
+    }
+    RenderJob &job = *m_job;
+    job.field = &field;
+    field.skippedIters = 0;
+    field.glitchReferences = 0;
+    field.unfixedGlitches = 0;
+
+    // The rectangles are cut along the tile grid : each part of a tile is a task, and lies in a single
+    // tile for the series approximation
+    std::vector<PixelRect> tasks;
+    for (const PixelRect &rect : rects)
+    {
+        for (uint ty = rect.y0 / TILE_SIZE; ty * TILE_SIZE < rect.y1; ++ty)
+        {
+            for (uint tx = rect.x0 / TILE_SIZE; tx * TILE_SIZE < rect.x1; ++tx)
+            {
+                const PixelRect tile{std::max(rect.x0, tx * TILE_SIZE), std::max(rect.y0, ty * TILE_SIZE),
+                                     std::min(rect.x1, (tx + 1) * TILE_SIZE), std::min(rect.y1, (ty + 1) * TILE_SIZE)};
+                tasks.push_back(tile);
+                if (job.series)
+                {
+                    const uint pixels = (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+                    field.skippedIters += uint64(job.seriesSkip[ty * tilesX + tx] - 1) * pixels;
+                }
+            }
+        }
+    }
+    return tasks;
+}
+
+void CpuRenderer::renderRects(const View &view, ShaderType shader, IterationField &field,
+                              const std::vector<PixelRect> &rects) const
+{
+    const std::vector<PixelRect> tasks = prepareRects(view, shader, field, rects);
+    const RenderJob &job = *m_job;
+    m_scheduler.run(uint(tasks.size()), [this, &job, &tasks](uint task) { renderTile(job, tasks[task]); });
+
+    if (shader == SHADER_PERTURBATION)
+    {
+        fixGlitches(job);
+    }
+}
+
+void CpuRenderer::startRects(const View &view, ShaderType shader, IterationField &field,
+                             const std::vector<PixelRect> &rects)
+{
+    CORE_ASSERT(!m_async, "Rectangles already being computed");
+    m_async.reset(new AsyncRects);
+    AsyncRects &async = *m_async;
+    async.tasks = prepareRects(view, shader, field, rects);
+    const RenderJob &job = *m_job;
+    m_scheduler.start(uint(async.tasks.size()), [this, &job, &async](uint task) {
+        if (async.cancelled)
+        {
+            return;
+        }
+        renderTile(job, async.tasks[task]);
+        // Perturbation tiles are handed back with their glitches fixed, at the end
+        if (job.shader != SHADER_PERTURBATION)
+        {
+            std::lock_guard<std::mutex> lock(async.mutex);
+            async.finished.push_back(async.tasks[task]);
+        }
+    });
+}
+
+bool CpuRenderer::finishRects(std::vector<PixelRect> &finished)
+{
+    CORE_ASSERT(m_async, "No rectangles being computed");
+    AsyncRects &async = *m_async;
+    const bool done = m_scheduler.isDone();
+    if (done && m_job->shader == SHADER_PERTURBATION)
+    {
+        fixGlitches(*m_job);
+        async.finished = async.tasks;
+    }
+    {
+        std::lock_guard<std::mutex> lock(async.mutex);
+        finished.insert(finished.end(), async.finished.begin(), async.finished.end());
+        async.finished.clear();
+    }
+    if (done)
+    {
+        m_scheduler.wait();
+        m_async.reset();
+    }
+    return done;
+}
+
+void CpuRenderer::cancelRects(std::vector<PixelRect> &finished)
+{
+    if (!m_async)
+    {
+        return;
+    }
+    m_async->cancelled = true;
+    m_scheduler.wait();
+    finished.insert(finished.end(), m_async->finished.begin(), m_async->finished.end());
+    m_async.reset();
+}
+
+void CpuRenderer::fixGlitches(const RenderJob &job) const
+{
+    const View &view = job.view;
+    IterationField &field = *job.field;
+    const uint limbs = BigFixed::limbsForScale(view.preciseScale);
+    const FloatExp &unit = job.primary.unit;
+
+    // Compute again the given pixels with a reference, in parallel
+    auto renderPixels = [&](const std::vector<uint> &pixels, const PerturbationReference &reference) {
+        const uint chunks = uint((pixels.size() + TILE_SIZE - 1) / TILE_SIZE);
+        m_scheduler.run(chunks, [&](uint chunk) {
+            const uint end = std::min(uint(pixels.size()), (chunk + 1) * TILE_SIZE);
+            for (uint k = chunk * TILE_SIZE; k < end; ++k)
+            {
+                const uint row = pixels[k] / view.width;
+                const uint col = pixels[k] % view.width;
+                const EscapeResult result =
+                    escapePerturbation(pixelPosition(col, view.width, view.originX),
+                                       pixelPosition(view.height - 1 - row, view.height, view.originY), view, reference);
+                field.iters[pixels[k]] = result.iters;
+                field.norms[pixels[k]] = result.norm;
+            }
+        });
+    };
+
+    std::vector<bool> visited(field.iters.size());
+    std::vector<uint> blob;
+    std::vector<uint> queue;
+    // Each pass places references on the glitches left by the previous one, a last one finds the glitches left
+    for (uint pass = 0; pass <= MAX_GLITCH_PASSES; ++pass)
+    {
+        // Find the blobs of glitched pixels (4-connected), largest first
+        std::vector<std::vector<uint>> blobs;
+        std::fill(visited.begin(), visited.end(), false);
+        for (uint start = 0; start < field.iters.size(); ++start)
+        {
+            if (visited[start] || field.iters[start] != GLITCHED_PIXEL)
+            {
+                continue;
+            }
+            blob.clear();
+            queue.assign(1, start);
+            visited[start] = true;
+            while (!queue.empty())
+            {
+                const uint n = queue.back();
+                queue.pop_back();
+                blob.push_back(n);
+                const uint row = n / view.width;
+                const uint col = n % view.width;
+                const uint neighbours[4] = {col > 0 ? n - 1 : n, col + 1 < view.width ? n + 1 : n,
+                                            row > 0 ? n - view.width : n, row + 1 < view.height ? n + view.width : n};
+                for (uint next : neighbours)
+                {
+                    if (!visited[next] && field.iters[next] == GLITCHED_PIXEL)
+                    {
+                        visited[next] = true;
+                        queue.push_back(next);
+                    }
+                }
+            }
+            blobs.push_back(blob);
+        }
+        if (blobs.empty())
+        {
+            return;
+        }
+        std::sort(blobs.begin(), blobs.end(),
+                  [](const std::vector<uint> &a, const std::vector<uint> &b) { return a.size() > b.size(); });
+
+        for (uint b = 0; b < blobs.size(); ++b)
+        {
+            // Out of passes or references : the remaining glitches keep the primary reference result
+            if (pass == MAX_GLITCH_PASSES || field.glitchReferences >= MAX_GLITCH_REFERENCES)
+            {
+                PerturbationReference primary = job.primary;
+                primary.series = nullptr;
+                primary.detectGlitches = false;
+                for (uint k = b; k < blobs.size(); ++k)
+                {
+                    renderPixels(blobs[k], primary);
+                    field.unfixedGlitches += uint(blobs[k].size());
+                }
+                return;
+            }
+
+            // The new reference is the pixel where the glitch is the strongest (smallest |z|/|Z|)
+            const std::vector<uint> &pixels = blobs[b];
+            const uint center = *std::min_element(pixels.begin(), pixels.end(),
+                                                  [&](uint p, uint q) { return field.norms[p] < field.norms[q]; });
+            PerturbationReference reference;
+            reference.unit = unit;
+            pixelDelta(pixelPosition(center % view.width, view.width, view.originX),
+                       pixelPosition(view.height - 1 - center / view.width, view.height, view.originY), view,
+                       reference.offsetX, reference.offsetY);
+            const ReferenceOrbit orbit(view.preciseCenterX + BigFixed(FloatExp(reference.offsetX) * unit),
+                                       view.preciseCenterY + BigFixed(FloatExp(reference.offsetY) * unit), view.iters,
+                                       limbs);
+            reference.orbit = &orbit;
+
+            std::unique_ptr<BlaTable> bla;
+            if (job.bla)
+            {
+                double dcMax = 0.0;
+                for (uint n : pixels)
+                {
+                    double dcx, dcy;
+                    pixelDelta(pixelPosition(n % view.width, view.width, view.originX),
+                               pixelPosition(view.height - 1 - n / view.width, view.height, view.originY), view, dcx, dcy);
+                    dcMax = std::max(dcMax, std::hypot(dcx - reference.offsetX, dcy - reference.offsetY));
+                }
+                bla.reset(new BlaTable(orbit, FloatExp(dcMax) * unit));
+                reference.bla = bla.get();
+            }
+
+            // Pixels still glitched with this reference are left for the next pass
+            renderPixels(pixels, reference);
+            ++field.glitchReferences;
+        }
+    }
+}
+
+template <typename ColorFunction>
+std::vector<uchar> CpuRenderer::colorPixels(const IterationField &field, const ColorFunction &color) const
+{
+    const uint format_bytes = 4; // RGBA
+    std::vector<uchar> pixels(format_bytes * field.width * field.height, 0);
+
+    // One task per row : the colors of large stills are computed on all cores too
+    m_scheduler.run(field.height, [&](uint row) {
+        for (uint n = row * field.width; n < (row + 1) * field.width; ++n)
+        {
+            // Points in the set keep the shaders' default color (0,0,0,0)
+            if (field.iters[n] < field.maxIters)
+            {
+                const Rgba c = color(field.iters[n], field.norms[n]);
+                pixels[format_bytes * n + 0] = toUnorm8(c.r);
+                pixels[format_bytes * n + 1] = toUnorm8(c.g);
+                pixels[format_bytes * n + 2] = toUnorm8(c.b);
+                pixels[format_bytes * n + 3] = toUnorm8(c.a);
+            }
+        }
+    });
+    return pixels;
+}
+
+std::vector<uchar> CpuRenderer::colorize(const IterationField &field, const Palette &palette, float offset) const
+{
+    const float period = palette.cycle(field.maxIters);
+    return colorPixels(field, [&](uint iters, float radius) {
+        return paletteColor(palette, period, offset, iters, radius);
+    });
+}
+
+std::vector<float> CpuRenderer::equalization(const IterationField &field) const
+{
+    const uint bins = field.maxIters; // escaped pixels only
+    std::vector<float> cdf(bins + 1, 0.f);
+    if (bins == 0)
+    {
+        return cdf;
+    }
+
+    // Partial histograms, one per band of rows. A band per thread : each one is counted by a single
+    // worker, without atomics, and there are few of them to merge.
+    const uint bands = std::max(1u, std::min(field.height, getThreadCount()));
+    std::vector<std::vector<uint>> partial(bands);
+    m_scheduler.run(bands, [&](uint band) {
+        std::vector<uint> &histogram = partial[band];
+        histogram.assign(bins, 0u);
+        const uint first = uint(uint64(field.height) * band / bands) * field.width;
+        const uint last = uint(uint64(field.height) * (band + 1) / bands) * field.width;
+        for (uint n = first; n < last; ++n)
+        {
+            if (field.iters[n] < bins)
+            {
+                ++histogram[field.iters[n]];
+            }
+        }
+    });
+
+    // Reduction : each block of bins is summed over the bands by one task, into the first band,
+    // along with the total of the block
+    const uint blockSize = 4096;
+    const uint blocks = (bins + blockSize - 1) / blockSize;
+    std::vector<uint64> blockTotals(blocks + 1, 0);
+    std::vector<uint> &histogram = partial[0];
+    m_scheduler.run(blocks, [&](uint block) {
+        uint64 total = 0;
+        for (uint k = block * blockSize; k < std::min(bins, (block + 1) * blockSize); ++k)
+        {
+            for (uint band = 1; band < bands; ++band)
+            {
+                histogram[k] += partial[band][k];
+            }
+            total += histogram[k];
+        }
+        blockTotals[block + 1] = total;
+    });
+
+    // Prefix sum : exclusive scan of the block totals, then of the bins of each block in parallel
+    for (uint block = 0; block < blocks; ++block)
+    {
+        blockTotals[block + 1] += blockTotals[block];
+    }
+    const uint64 escaped = blockTotals[blocks];
+    if (escaped == 0)
+    {
+        return cdf;
+    }
+    m_scheduler.run(blocks, [&](uint block) {
+        uint64 count = blockTotals[block];
+        for (uint k = block * blockSize; k < std::min(bins, (block + 1) * blockSize); ++k)
+        {
+            cdf[k] = static_cast<float>(double(count) / double(escaped));
+            count += histogram[k];
+        }
+    });
+    cdf[bins] = 1.f;
+    return cdf;
+}
+
+std::vector<uchar> CpuRenderer::colorizeEqualized(const IterationField &field, const Palette &palette,
+                                                  float offset) const
+{
+    const std::vector<float> cdf = equalization(field);
+    return colorPixels(field, [&](uint iters, float radius) {
+        return paletteSample(palette, equalizedCoordinate(cdf, iters, radius) + offset);
+    });
+}
+
+std::vector<uchar> CpuRenderer::renderFrame(const View &view, ShaderType shader, const Palette &palette) const
+{
+    IterationField field;
+    render(view, shader, field);
+    return colorize(field, palette);
+}
@@ -0,0 +1,126 @@
+#ifndef CPURENDERER_HPP_
+#define CPURENDERER_HPP_
+
+#include <CoreMacros.hpp>
+#include <memory>
+#include <vector>
+
+#include "View.hpp"
+#include "IterationField.hpp"
+#include "EscapeKernels.hpp"
+#include "SimdKernels.hpp"
+#include "TileScheduler.hpp"
+#include "Palette.hpp"
+
+/// How the pixels of a tile are computed
+enum RenderMode
+{
+    RENDER_FULL = 0,         // Compute every pixel
+    RENDER_SUBDIVIDE,        // Mariani-Silver : fill rectangles whose border has a uniform iteration count
+    RENDER_SUBDIVIDE_STRICT, // Mariani-Silver, only filling rectangles proven inside the set (same result as RENDER_FULL).
+                             // The proof runs in double precision around c, or around the reference orbit for
+                             // perturbation : with the other shaders nothing is filled past zooms of about 1e-15, nor
+                             // past 1e-290 with perturbation
+};
+
+/// Headless Mandelbrot renderer, running the shaders' escape-time math on the CPU,
+/// as well as CPU-only kernels (perturbation for deep zooms).
+/// The frame is split in square tiles which are processed by all available cores,
+/// balanced by a work-stealing scheduler.
+class CpuRenderer
+{
+  public:
+    static const uint TILE_SIZE = 32; // Tile width and height in pixels
+
+    static const uint MAX_GLITCH_PASSES = 4;      // Glitches left after a secondary reference get another one, up to
+                                                  // this number of references per glitch...
+    static const uint MAX_GLITCH_REFERENCES = 64; // ...and per frame. The pixels still glitched then keep the primary
+                                                  // reference result (see IterationField::unfixedGlitches).
+
+    /// Create a renderer using the given number of threads (0 = one per core)
+    CpuRenderer(uint threads = 0);
+    ~CpuRenderer();
+
+    /// Compute the iteration field of a view with the kernel matching the given shader
+    void render(const View &view, ShaderType shader, IterationField &field) const;
+
+    /// Compute only the given rectangles of the field, keeping its other pixels : e.g. the strips exposed
+    /// by IterationField::scroll() when the view moves by whole pixels. The field must have the view's size.
+    void renderRects(const View &view, ShaderType shader, IterationField &field,
+                     const std::vector<PixelRect> &rects) const;
+
+    /// Start computing rectangles of the field like renderRects(), on the worker threads, and return at once.
+    /// Until finishRects() returns true or cancelRects() is called, the renderer must not be used otherwise, and
+    /// only the tiles handed back by finishRects() may be read from the field.
+    void startRects(const View &view, ShaderType shader, IterationField &field, const std::vector<PixelRect> &rects);
+
+    /// Append the tiles computed since the last call to `finished` (perturbation tiles : all of them at the
+    /// end, once the glitches are fixed), and return true when all the rectangles are done. Doesn't wait.
+    bool finishRects(std::vector<PixelRect> &finished);
+
+    /// Stop computing the rectangles started by startRects() : wait for the tiles being computed and append
+    /// the ones done to `finished`. The pixels of the others are left as they are. Does nothing if none is started.
+    void cancelRects(std::vector<PixelRect> &finished);
+
+    /// Color an iteration field to RGBA pixels, as Color.glsl does. `offset` shifts the palette, in cycles.
+    std::vector<uchar> colorize(const IterationField &field, const Palette &palette, float offset = 0.f) const;
+
+    /// Cumulative histogram of the iterations of the escaped pixels, for histogram equalization : element
+    /// k (in [0, maxIters]) is the fraction of them that escaped before iteration k. The partial histograms
+    /// of bands of rows are counted in parallel, then merged and prefix-summed in parallel by blocks of bins.
+    std::vector<float> equalization(const IterationField &field) const;
+
+    /// Color an iteration field with histogram equalization : the palette spans the escaped pixels once,
+    /// evenly whatever their iterations (equalize mode of Color.glsl)
+    std::vector<uchar> colorizeEqualized(const IterationField &field, const Palette &palette, float offset = 0.f) const;
+
+    /// Render and color a full frame, ready for save_frame()
+    std::vector<uchar> renderFrame(const View &view, ShaderType shader, const Palette &palette) const;
+
+    /// Number of worker threads
+    uint getThreadCount() const { return m_scheduler.getThreadCount(); }
+
+    /// Instruction set used by the double precision kernel (defaults to the widest available)
+    SimdIsa getSimdIsa() const { return m_simdIsa; }
+    void setSimdIsa(SimdIsa isa);
+
+    /// How tiles are computed (defaults to every pixel)
+    RenderMode getRenderMode() const { return m_renderMode; }
+    void setRenderMode(RenderMode mode);
+
+  private:
+    struct RenderJob;
+    struct AsyncRects;
+
+    /// Common part of renderRects() and startRects() : the job for the view, and the tiles to compute
+    std::vector<PixelRect> prepareRects(const View &view, ShaderType shader, IterationField &field,
+                                        const std::vector<PixelRect> &rects) const;
+
+    /// Compute the pixels of a tile, or of the part of a tile in a rectangle to render
+    void renderTile(const RenderJob &job, const PixelRect &tile) const;
+
+    /// Compute a tile, or part of a tile, by Mariani-Silver subdivision
+    void subdivideTile(const RenderJob &job, uint x0, uint y0, uint x1, uint y1) const;
+
+    /// Compute `count` (at most TILE_SIZE) consecutive pixels of a row, starting at column `col`
+    void computeRow(const RenderJob &job, uint row, uint col, uint count, EscapeResult *results) const;
+
+    /// Per-frame data of a job : the center in the kernel's precision, the perturbation reference and series
+    void prepareJob(RenderJob &job) const;
+
+    /// Perturbation : compute the glitched pixels again, with secondary references
+    void fixGlitches(const RenderJob &job) const;
+
+    /// RGBA pixels of the field, color(iters, radius) for the escaped points
+    template <typename ColorFunction>
+    std::vector<uchar> colorPixels(const IterationField &field, const ColorFunction &color) const;
+
+  private:
+    mutable TileScheduler m_scheduler; // worker threads, kept across renders
+    mutable std::unique_ptr<RenderJob> m_job; // last frame rendered
+    std::unique_ptr<AsyncRects> m_async;      // rectangles being computed in the background, if any
+    SimdIsa m_simdIsa;
+    RenderMode m_renderMode;
+};
+
+#endif // CPURENDERER_HPP_
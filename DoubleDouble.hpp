@@ -0,0 +1,121 @@
+#ifndef DOUBLEDOUBLE_HPP_
+#define DOUBLEDOUBLE_HPP_
+
+#include <cmath>
+
+/// Quadruple precision emulation on the CPU : a value is the unevaluated sum of two doubles,
+/// with about 106 bits of mantissa. Same algorithms as FloatFloat, except the exact products,
+/// which use a fused multiply-add instead of Dekker's splitting : a * b - fma(a, b, -ab) is
+/// the rounding error of a * b.
+/// The error-free transformations need strict IEEE rounding : this file must not be compiled
+/// with -ffast-math.
+struct DoubleDouble
+{
+    double high;
+    double low;
+
+    DoubleDouble() {} /// Create an uninitialized DoubleDouble
+    DoubleDouble(double h, double l) : high(h), low(l) {} /// Create a DoubleDouble from two values (|l| <= ulp(h) / 2)
+    DoubleDouble(double x) : high(x), low(0.0) {} /// Create a DoubleDouble from a double
+
+    /// Round to nearest double
+    double toDouble() const { return high + low; }
+};
+
+/// a + b = s + e exactly, for any a and b
+inline DoubleDouble dd_two_sum(double a, double b)
+{
+    const double s = a + b;
+    const double v = s - a;
+    const double e = (a - (s - v)) + (b - v);
+    return DoubleDouble(s, e);
+}
+
+/// a + b = s + e exactly, if |a| >= |b|
+inline DoubleDouble dd_quick_two_sum(double a, double b)
+{
+    const double s = a + b;
+    return DoubleDouble(s, b - (s - a));
+}
+
+/// a * b = p + e exactly
+inline DoubleDouble dd_two_prod(double a, double b)
+{
+    const double p = a * b;
+    return DoubleDouble(p, std::fma(a, b, -p));
+}
+
+inline DoubleDouble dd_neg(DoubleDouble x)
+{
+    return DoubleDouble(-x.high, -x.low);
+}
+
+inline DoubleDouble dd_add(DoubleDouble a, DoubleDouble b)
+{
+    const DoubleDouble s = dd_two_sum(a.high, b.high);
+    const DoubleDouble t = dd_two_sum(a.low, b.low);
+    const DoubleDouble u = dd_quick_two_sum(s.high, s.low + t.high);
+    return dd_quick_two_sum(u.high, u.low + t.low);
+}
+
+inline DoubleDouble dd_sub(DoubleDouble a, DoubleDouble b)
+{
+    return dd_add(a, dd_neg(b));
+}
+
+inline DoubleDouble dd_mul(DoubleDouble a, DoubleDouble b)
+{
+    const DoubleDouble p = dd_two_prod(a.high, b.high);
+    return dd_quick_two_sum(p.high, p.low + (a.high * b.low + a.low * b.high));
+}
+
+/// x^2, one product less than dd_mul(x, x)
+inline DoubleDouble dd_sqr(DoubleDouble x)
+{
+    const DoubleDouble p = dd_two_prod(x.high, x.high);
+    return dd_quick_two_sum(p.high, p.low + 2.0 * (x.high * x.low));
+}
+
+/// 2 x, exact
+inline DoubleDouble dd_mul2(DoubleDouble x)
+{
+    return DoubleDouble(2.0 * x.high, 2.0 * x.low);
+}
+
+inline int dd_cmp(DoubleDouble a, DoubleDouble b)
+{
+    if (a.high != b.high)
+    {
+        return a.high < b.high ? -1 : 1;
+    }
+    if (a.low != b.low)
+    {
+        return a.low < b.low ? -1 : 1;
+    }
+    return 0;
+}
+
+// Complex operations on doubledouble-based complex numbers
+struct ComplexDD
+{
+    DoubleDouble re; // real part
+    DoubleDouble im; // imaginary part
+};
+
+inline ComplexDD cdd_add(ComplexDD a, ComplexDD b)
+{
+    return ComplexDD{dd_add(a.re, b.re), dd_add(a.im, b.im)};
+}
+
+/// (p + i q)^2 = p^2 - q^2 + 2 i p q
+inline ComplexDD cdd_sqr(ComplexDD a)
+{
+    return ComplexDD{dd_sub(dd_sqr(a.re), dd_sqr(a.im)), dd_mul2(dd_mul(a.re, a.im))};
+}
+
+inline DoubleDouble cdd_norm(ComplexDD a)
+{
+    return dd_add(dd_sqr(a.re), dd_sqr(a.im));
+}
+
+#endif // DOUBLEDOUBLE_HPP_
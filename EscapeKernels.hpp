@@ -0,0 +1,364 @@
+#ifndef ESCAPEKERNELS_HPP_
+#define ESCAPEKERNELS_HPP_
+
+// CPU versions of the escape-time loops of PixelF.glsl, PixelFF.glsl, PixelD.glsl and PixelQF.glsl.
+// A single loop, escapeTime<T>(), is instantiated for each number type (see Precision.hpp) :
+// each instance performs the same operations in the same order as its shader, so that
+// the CPU and GL renders give the same iteration counts.
+// The doubledouble instance has no shader : it is a CPU-only precision mode.
+
+#include <CoreMacros.hpp>
+#include <algorithm>
+
+#include "View.hpp"
+#include "Precision.hpp"
+
+/// Result of the escape-time iteration for one pixel
+struct EscapeResult
+{
+    uint iters; // iteration at which the orbit escaped, or max iters if it did not
+    float norm; // |z|^2 after the escaping iteration, as given to the coloring pass
+};
+
+/// Brent's cycle detection schedule : the checkpoint moves to the current point
+/// after 1, 2, 4, 8... iterations
+struct PeriodicityCheckpoint
+{
+    uint interval{1}; // iterations between the last checkpoint and the next one
+    uint count{0};    // iterations since the last checkpoint
+
+    /// Count one iteration, return true if the checkpoint must move to the current point
+    bool advance()
+    {
+        if (++count == interval)
+        {
+            count = 0;
+            interval *= 2;
+            return true;
+        }
+        return false;
+    }
+};
+
+/// True if c is inside the main cardioid or the period-2 bulb (Interior.glsl), in the precision of T
+template <typename T>
+inline bool inMainCardioidOrBulb(const T &x, const T &y)
+{
+    typedef Precision<T> P;
+    const T xq = P::add(x, P::constant(-0.25f));
+    const T y2 = P::sqr(y);
+    const T q = P::add(P::sqr(xq), y2);
+    if (P::lessEqual(P::mul(q, P::add(q, xq)), P::mul(P::constant(0.25f), y2)))
+    {
+        return true;
+    }
+    const T xb = P::add(x, P::constant(1.0f));
+    return P::lessEqual(P::add(P::sqr(xb), y2), P::constant(0.0625f));
+}
+
+/// Iterations between two escape tests of escapeTime<T>() (ESCAPE_UNROLL of Interior.glsl)
+const uint ESCAPE_UNROLL = 8;
+
+/// First iterations of escapeTime<T>() tested one at a time : most escaping orbits leave within
+/// a few iterations, where rolling back a block would cost more than the tests it saves
+const uint ESCAPE_WARMUP = 2 * ESCAPE_UNROLL;
+
+/// Orbit of escapeTime<T>() : z with its squares, the periodicity checkpoint and the derivative
+template <typename T>
+struct EscapeOrbit
+{
+    typedef Precision<T> P;
+    typedef typename P::Real Real;
+
+    T x, y;   // z
+    T x2, y2; // squares of z, computed once per iteration : they serve both the escape test and the next step
+    T checkX, checkY;
+    PeriodicityCheckpoint checkpoint;
+    Real dzx, dzy; // dz_n/dz_1, z_1 = c
+
+    EscapeOrbit(const T &cx, const T &cy)
+        : x(cx), y(cy), x2(P::sqr(cx)), y2(P::sqr(cy)), checkX(cx), checkY(cy), dzx(1), dzy(0)
+    {
+    }
+
+    /// dz = 2 z dz, with z before the step (Interior.glsl)
+    void derive()
+    {
+        const Real zx = P::real(x);
+        const Real zy = P::real(y);
+        const Real ndzx = Real(2) * (zx * dzx - zy * dzy);
+        dzy = Real(2) * (zx * dzy + zy * dzx);
+        dzx = ndzx;
+    }
+
+    /// True if the orbit is attracted by a cycle
+    bool attracted() const { return dzx * dzx + dzy * dzy < Real(DERIVATIVE_EPSILON); }
+
+    /// z = z^2 + c
+    void step(const T &cx, const T &cy)
+    {
+        const T xy2 = P::twiceProduct(x, y);
+        x = P::add(P::sub(x2, y2), cx);
+        y = P::add(xy2, cy);
+        x2 = P::sqr(x);
+        y2 = P::sqr(y);
+    }
+
+    /// True if z is back to the checkpoint, which then follows Brent's schedule
+    bool periodic(const P &precision)
+    {
+        const typename P::Real dx = precision.difference(x, checkX);
+        const typename P::Real dy = precision.difference(y, checkY);
+        const bool result = dx * dx + dy * dy < P::periodicityEpsilon();
+        if (checkpoint.advance())
+        {
+            checkX = x;
+            checkY = y;
+        }
+        return result;
+    }
+
+    /// z = z^2 + c followed by the tests, in the order of the shaders.
+    /// Returns true if the orbit stopped at iteration i, with its result.
+    bool iterate(uint i, const T &cx, const T &cy, const View &view, const P &precision, EscapeResult &result)
+    {
+        if (view.features & FEATURE_DERIVATIVE)
+        {
+            derive();
+        }
+        step(cx, cy);
+        float norm;
+        if (P::escaped(x, y, x2, y2, norm))
+        {
+            result = EscapeResult{i, norm};
+            return true;
+        }
+        if ((view.features & FEATURE_PERIODICITY) && periodic(precision))
+        {
+            result = EscapeResult{view.iters, 0.f}; // The orbit is periodic, c is in the set
+            return true;
+        }
+        if ((view.features & FEATURE_DERIVATIVE) && attracted())
+        {
+            result = EscapeResult{view.iters, 0.f}; // The orbit converges to a cycle, c is in the set
+            return true;
+        }
+        return false;
+    }
+};
+
+/// Escape-time iteration of one pixel with numbers of type T.
+/// After the first ESCAPE_WARMUP iterations, the iterations run in blocks of ESCAPE_UNROLL without early exit :
+/// the escape and interior tests are only accumulated, and checked at the end of the block. If one of them
+/// fired, the orbit rolls back to the start of the block, which is replayed one step at a time to find the exact
+/// iteration. The results are the same as with a test after every iteration.
+template <typename T>
+inline EscapeResult escapeTime(float posX, float posY, const View &view, const Precision<T> &precision)
+{
+    typedef Precision<T> P;
+
+    T cx, cy;
+    precision.pixel(posX, posY, cx, cy);
+    if ((view.features & FEATURE_SHAPE_CHECK) && inMainCardioidOrBulb(cx, cy))
+    {
+        return EscapeResult{view.iters, 0.f};
+    }
+
+    const bool periodicity = (view.features & FEATURE_PERIODICITY) != 0;
+    const bool derivative = (view.features & FEATURE_DERIVATIVE) != 0;
+    EscapeOrbit<T> orbit(cx, cy);
+    EscapeResult result{view.iters, 0.f};
+
+    uint i = 0;
+    for (; i < std::min(ESCAPE_WARMUP, view.iters); ++i)
+    {
+        if (orbit.iterate(i, cx, cy, view, precision, result))
+        {
+            return result;
+        }
+    }
+
+    for (; i + ESCAPE_UNROLL <= view.iters; i += ESCAPE_UNROLL)
+    {
+        const EscapeOrbit<T> saved = orbit;
+        bool stop = false;
+        for (uint k = 0; k < ESCAPE_UNROLL; ++k)
+        {
+            float norm;
+            if (derivative)
+            {
+                orbit.derive();
+            }
+            orbit.step(cx, cy);
+            stop |= P::escaped(orbit.x, orbit.y, orbit.x2, orbit.y2, norm);
+            stop |= periodicity && orbit.periodic(precision);
+            stop |= derivative && orbit.attracted();
+        }
+        if (stop)
+        {
+            orbit = saved;
+            break;
+        }
+    }
+
+    // Step by step : the block where the orbit stopped, or the last iterations
+    for (; i < view.iters; ++i)
+    {
+        if (orbit.iterate(i, cx, cy, view, precision, result))
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+/// PixelF.glsl
+inline EscapeResult escapeFloat(float posX, float posY, const View &view)
+{
+    return escapeTime(posX, posY, view, Precision<float>(view));
+}
+
+/// PixelFF.glsl
+inline EscapeResult escapeFloatFloat(float posX, float posY, const View &view)
+{
+    return escapeTime(posX, posY, view, Precision<FloatFloat>(view));
+}
+
+/// PixelD.glsl
+inline EscapeResult escapeDouble(float posX, float posY, const View &view)
+{
+    return escapeTime(posX, posY, view, Precision<double>(view));
+}
+
+/// PixelQF.glsl. The center is given separately, as the uniforms : a double can't hold it.
+inline EscapeResult escapeQuadFloat(float posX, float posY, const View &view, const QuadFloat *center)
+{
+    return escapeTime(posX, posY, view, Precision<QuadFloat>(view, center));
+}
+
+/// Doubledouble precision, for zooms down to about 1e-30 (CPU only).
+/// The center is given separately, since a double can't hold it.
+inline EscapeResult escapeDoubleDouble(float posX, float posY, const View &view, const ComplexDD &center)
+{
+    return escapeTime(posX, posY, view, Precision<DoubleDouble>(view, center));
+}
+
+/// escapeFloatFloat() on up to N pixels of a row at once, with the batch floatfloat operations.
+/// Each lane keeps its own escape flag : the loop runs until all lanes are done.
+template <uint N>
+inline void escapeFloatFloatBatch(const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    CORE_ASSERT(count <= N, "Too many pixels for the batch");
+    const Precision<FloatFloat> precision(view);
+    const bool shapeCheck = (view.features & FEATURE_SHAPE_CHECK) != 0;
+
+    // Starting points, lanes past the end of the row are disabled from the start
+    ComplexFFBatch<N> c;
+    int active[N];
+    uint iters[N];
+    float norms[N];
+    for (uint k = 0; k < N; ++k)
+    {
+        FloatFloat cx, cy;
+        precision.pixel(k < count ? posX[k] : 0.f, posY, cx, cy);
+        c.re.high[k] = cx.high;
+        c.re.low[k] = cx.low;
+        c.im.high[k] = cy.high;
+        c.im.low[k] = cy.low;
+        active[k] = k < count && !(shapeCheck && inMainCardioidOrBulb(cx, cy)) ? 1 : 0;
+        iters[k] = view.iters;
+        norms[k] = 0.f;
+    }
+
+    // All lanes start together, so they share the checkpoint schedule
+    const bool periodicity = (view.features & FEATURE_PERIODICITY) != 0;
+    PeriodicityCheckpoint checkpoint;
+    ComplexFFBatch<N> check = c;
+
+    // Derivative from the high parts, as in the shader
+    const bool derivative = (view.features & FEATURE_DERIVATIVE) != 0;
+    float dzx[N], dzy[N];
+    for (uint k = 0; k < N; ++k)
+    {
+        dzx[k] = 1.f;
+        dzy[k] = 0.f;
+    }
+
+    const FloatFloatBatch<N> sqMax = ff_broadcast<N>(FloatFloat(4.0f, 0.f));
+    ComplexFFBatch<N> p = c;
+
+    // Whether all lanes are done is only checked every ESCAPE_UNROLL iterations : meanwhile,
+    // the finished lanes go on iterating, masked out of the results
+    uint i = 0;
+    bool running = true;
+    while (i < view.iters && running)
+    {
+        const uint blockEnd = std::min(view.iters, i + ESCAPE_UNROLL);
+        for (; i < blockEnd; ++i)
+        {
+            if (derivative)
+            {
+                for (uint k = 0; k < N; ++k)
+                {
+                    const float ndzx = 2.f * (p.re.high[k] * dzx[k] - p.im.high[k] * dzy[k]);
+                    dzy[k] = 2.f * (p.re.high[k] * dzy[k] + p.im.high[k] * dzx[k]);
+                    dzx[k] = ndzx;
+                }
+            }
+            p = cff_add(cff_mul(p, p), c);
+            int cmp[N];
+            ff_cmp(cff_norm(p), sqMax, cmp);
+            for (uint k = 0; k < N; ++k)
+            {
+                // dot(p,p) on the vec4 representation
+                const float dot = p.re.high[k] * p.re.high[k] + p.re.low[k] * p.re.low[k] +
+                                  p.im.high[k] * p.im.high[k] + p.im.low[k] * p.im.low[k];
+                const bool escaped = active[k] != 0 && cmp[k] > 0;
+                norms[k] = escaped ? dot : norms[k];
+                iters[k] = escaped ? i : iters[k];
+                active[k] = escaped ? 0 : active[k];
+            }
+
+            if (periodicity)
+            {
+                // The difference is tiny when it matters : its high parts are enough
+                const FloatFloatBatch<N> dx = ff_add(p.re, ff_neg(check.re));
+                const FloatFloatBatch<N> dy = ff_add(p.im, ff_neg(check.im));
+                for (uint k = 0; k < N; ++k)
+                {
+                    // Lanes back to their checkpoint are in the set
+                    const bool periodic = dx.high[k] * dx.high[k] + dy.high[k] * dy.high[k] < PERIODICITY_EPSILON_FF;
+                    active[k] = periodic ? 0 : active[k];
+                }
+                if (checkpoint.advance())
+                {
+                    check = p;
+                }
+            }
+
+            if (derivative)
+            {
+                for (uint k = 0; k < N; ++k)
+                {
+                    // Lanes attracted by a cycle are in the set
+                    const bool attracted = dzx[k] * dzx[k] + dzy[k] * dzy[k] < DERIVATIVE_EPSILON;
+                    active[k] = attracted ? 0 : active[k];
+                }
+            }
+        }
+
+        int anyActive = 0;
+        for (uint k = 0; k < N; ++k)
+        {
+            anyActive |= active[k];
+        }
+        running = anyActive != 0;
+    }
+
+    for (uint k = 0; k < count; ++k)
+    {
+        results[k] = EscapeResult{iters[k], norms[k]};
+    }
+}
+
+#endif // ESCAPEKERNELS_HPP_
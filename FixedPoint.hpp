@@ -0,0 +1,205 @@
+#ifndef FIXEDPOINT_HPP_
+#define FIXEDPOINT_HPP_
+
+#include <CoreMacros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "BigFixed.hpp"
+
+/// Signed fixed-point number with N fraction limbs known at compile time, for the inner loop of
+/// the reference orbit. Same layout as BigFixed (base 2^32 limbs, most significant first, limb 0
+/// is the integer part), but in two's complement in a fixed-size array : additions are a single
+/// carry chain, and the products only compute the limbs that are kept.
+/// Products are truncated, with an error of a few units of the last limb.
+template <uint N>
+class FixedPoint
+{
+  public:
+    typedef std::uint32_t Limb;
+
+    /// Zero
+    FixedPoint()
+    {
+        for (uint k = 0; k <= N; ++k)
+        {
+            m_limbs[k] = 0u;
+        }
+    }
+
+    /// Conversion from a BigFixed, truncated or padded to N fraction limbs
+    explicit FixedPoint(const BigFixed &x)
+    {
+        for (uint k = 0; k <= N; ++k)
+        {
+            m_limbs[k] = x.getLimb(k);
+        }
+        if (x.isNegative())
+        {
+            negate();
+        }
+    }
+
+    bool isNegative() const { return (m_limbs[0] >> 31) != 0; }
+
+    /// Nearest double (truncated after 96 significant bits)
+    double toDouble() const
+    {
+        const FixedPoint a = abs();
+        uint first = 0;
+        while (first <= N && a.m_limbs[first] == 0)
+        {
+            ++first;
+        }
+        double result = 0.0;
+        for (uint k = first; k < first + 3 && k <= N; ++k)
+        {
+            result += std::ldexp(static_cast<double>(a.m_limbs[k]), -32 * int(k));
+        }
+        return isNegative() ? -result : result;
+    }
+
+    FixedPoint operator-() const
+    {
+        FixedPoint result(*this);
+        result.negate();
+        return result;
+    }
+
+    FixedPoint operator+(const FixedPoint &b) const
+    {
+        FixedPoint result;
+        uint64 carry = 0;
+        for (uint k = N + 1; k-- > 0;)
+        {
+            const uint64 sum = uint64(m_limbs[k]) + uint64(b.m_limbs[k]) + carry;
+            result.m_limbs[k] = static_cast<Limb>(sum);
+            carry = sum >> 32;
+        }
+        return result;
+    }
+
+    FixedPoint operator-(const FixedPoint &b) const
+    {
+        FixedPoint result;
+        uint64 borrow = 0;
+        for (uint k = N + 1; k-- > 0;)
+        {
+            const uint64 sub = uint64(b.m_limbs[k]) + borrow;
+            result.m_limbs[k] = static_cast<Limb>(uint64(m_limbs[k]) - sub);
+            borrow = m_limbs[k] < sub ? 1 : 0;
+        }
+        return result;
+    }
+
+    FixedPoint operator*(const FixedPoint &b) const
+    {
+        const FixedPoint x = abs();
+        const FixedPoint y = b.abs();
+
+        // Schoolbook product of the magnitudes as in BigFixed, limb i+j+1 of the product receiving
+        // x_i y_j, but only down to the first limb below the precision
+        Limb product[N + 3] = {};
+        for (uint i = N + 1; i-- > 0;)
+        {
+            uint64 carry = 0;
+            for (uint j = std::min(N, N + 1 - i) + 1; j-- > 0;)
+            {
+                const uint64 t = uint64(x.m_limbs[i]) * uint64(y.m_limbs[j]) + product[i + j + 1] + carry;
+                product[i + j + 1] = static_cast<Limb>(t);
+                carry = t >> 32;
+            }
+            product[i] = static_cast<Limb>(carry);
+        }
+        return fromProduct(product, isNegative() != b.isNegative());
+    }
+
+    /// x^2, about twice as fast as x * x : the cross products x_i x_j (i != j) are computed once and doubled
+    FixedPoint square() const
+    {
+        const FixedPoint x = abs();
+
+        // Cross products x_i x_j with j > i : the row's carry goes to limb 2i + 1
+        Limb product[N + 3] = {};
+        for (uint i = N + 1; i-- > 0;)
+        {
+            const uint last = std::min(N, N + 1 - i);
+            if (last <= i)
+            {
+                continue;
+            }
+            uint64 carry = 0;
+            for (uint j = last + 1; j-- > i + 1;)
+            {
+                const uint64 t = uint64(x.m_limbs[i]) * uint64(x.m_limbs[j]) + product[i + j + 1] + carry;
+                product[i + j + 1] = static_cast<Limb>(t);
+                carry = t >> 32;
+            }
+            product[2 * i + 1] = static_cast<Limb>(carry);
+        }
+
+        // Double the cross products
+        CORE_ASSERT((product[0] >> 31) == 0, "FixedPoint overflow");
+        for (uint k = 0; k < N + 3; ++k)
+        {
+            product[k] = (product[k] << 1) | (k + 1 < N + 3 ? product[k + 1] >> 31 : 0u);
+        }
+
+        // Add the squares x_i^2, at limbs 2i and 2i + 1
+        uint64 carry = 0;
+        for (uint k = N + 3; k-- > 0;)
+        {
+            uint64 t = uint64(product[k]) + carry;
+            const uint i = k / 2;
+            if (i <= N)
+            {
+                const uint64 s = uint64(x.m_limbs[i]) * uint64(x.m_limbs[i]);
+                t += (k & 1) ? (s & 0xffffffffu) : (s >> 32);
+            }
+            product[k] = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+        CORE_ASSERT(carry == 0, "FixedPoint overflow");
+        return fromProduct(product, false);
+    }
+
+    FixedPoint &operator+=(const FixedPoint &b) { return *this = *this + b; }
+    FixedPoint &operator-=(const FixedPoint &b) { return *this = *this - b; }
+
+  private:
+    /// Two's complement negation
+    void negate()
+    {
+        uint64 carry = 1;
+        for (uint k = N + 1; k-- > 0;)
+        {
+            const uint64 t = uint64(~m_limbs[k]) + carry;
+            m_limbs[k] = static_cast<Limb>(t);
+            carry = t >> 32;
+        }
+    }
+
+    FixedPoint abs() const { return isNegative() ? -*this : *this; }
+
+    /// Keep limbs 1..N+1 of a product of magnitudes (limb 0 is above the integer part)
+    static FixedPoint fromProduct(const Limb *product, bool negative)
+    {
+        CORE_ASSERT(product[0] == 0 && (product[1] >> 31) == 0, "FixedPoint overflow");
+        FixedPoint result;
+        for (uint k = 0; k <= N; ++k)
+        {
+            result.m_limbs[k] = product[k + 1];
+        }
+        if (negative)
+        {
+            result.negate();
+        }
+        return result;
+    }
+
+  private:
+    Limb m_limbs[N + 1];
+};
+
+#endif // FIXEDPOINT_HPP_
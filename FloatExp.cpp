@@ -0,0 +1,46 @@
+#include "FloatExp.hpp"
+
+#include <cstdio>
+
+std::string FloatExp::toString() const
+{
+    if (m_mantissa == 0.0 || !std::isfinite(m_mantissa))
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", m_mantissa);
+        return buffer;
+    }
+
+    // x = d * 10^e10 with 1 <= |d| < 10
+    const double exponent10 = std::floor(log10());
+    const double digits = std::pow(10.0, log10() - exponent10);
+    if (digits >= 9.9999999995) // rounding to the printed digits would give 10
+    {
+        return (m_mantissa < 0.0 ? "-" : "") + std::string("1e") + std::to_string(int64(exponent10) + 1);
+    }
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%s%.10ge%lld", m_mantissa < 0.0 ? "-" : "", digits,
+                  static_cast<long long>(exponent10));
+    return buffer;
+}
+
+FloatExp FloatExp::fromString(const std::string &str)
+{
+    // Split the decimal exponent off, so that the mantissa fits in a double
+    const size_t e = str.find_first_of("eE");
+    const double mantissa = std::stod(str.substr(0, e));
+    const int64 exponent10 = e == std::string::npos ? 0 : std::stoll(str.substr(e + 1));
+
+    // 10^|exponent10| by squaring
+    FloatExp power(1.0);
+    FloatExp square(10.0);
+    for (uint64 n = uint64(exponent10 < 0 ? -exponent10 : exponent10); n != 0; n >>= 1)
+    {
+        if (n & 1)
+        {
+            power *= square;
+        }
+        square *= square;
+    }
+    return exponent10 < 0 ? FloatExp(mantissa) / power : FloatExp(mantissa) * power;
+}
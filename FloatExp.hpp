@@ -0,0 +1,135 @@
+#ifndef FLOATEXP_HPP_
+#define FLOATEXP_HPP_
+
+#include <CoreMacros.hpp>
+#include <cmath>
+#include <string>
+
+/// Floating point number with a double mantissa and a separate 64-bit exponent : x = mantissa * 2^exponent.
+/// It has the precision of a double, but no practical range limit, for zoom levels below 1e-308.
+/// The mantissa is renormalized to [0.5, 1) after every operation. Arithmetic is several times slower
+/// than on doubles : inner loops work on doubles relative to a FloatExp unit and only rescale from
+/// time to time (see Perturbation.hpp).
+class FloatExp
+{
+  public:
+    /// Zero
+    FloatExp() : m_mantissa(0.0), m_exponent(0) {}
+
+    /// Exact conversion from a double
+    FloatExp(double x) : m_mantissa(x), m_exponent(0) { normalize(); }
+
+    /// mantissa * 2^exponent
+    FloatExp(double mantissa, int64 exponent) : m_mantissa(mantissa), m_exponent(exponent) { normalize(); }
+
+    double getMantissa() const { return m_mantissa; }
+    int64 getExponent() const { return m_exponent; }
+
+    /// Nearest double, 0 or infinity out of the double range
+    double toDouble() const
+    {
+        if (m_exponent < -1100)
+        {
+            return 0.0 * m_mantissa;
+        }
+        if (m_exponent > 1100)
+        {
+            return m_mantissa * HUGE_VAL;
+        }
+        return std::ldexp(m_mantissa, int(m_exponent));
+    }
+
+    /// x * 2^n, exact
+    FloatExp ldexp(int64 n) const { return m_mantissa == 0.0 ? *this : FloatExp(m_mantissa, m_exponent + n); }
+
+    /// log2(|x|), -infinity for 0
+    double log2() const { return std::log2(std::abs(m_mantissa)) + double(m_exponent); }
+    double log10() const { return log2() * 0.30102999566398119521; }
+
+    FloatExp operator-() const { return FloatExp(-m_mantissa, m_exponent); }
+
+    FloatExp operator*(const FloatExp &b) const { return FloatExp(m_mantissa * b.m_mantissa, m_exponent + b.m_exponent); }
+    FloatExp operator/(const FloatExp &b) const { return FloatExp(m_mantissa / b.m_mantissa, m_exponent - b.m_exponent); }
+
+    FloatExp operator+(const FloatExp &b) const
+    {
+        if (m_mantissa == 0.0)
+        {
+            return b;
+        }
+        if (b.m_mantissa == 0.0)
+        {
+            return *this;
+        }
+        // Align on the largest exponent. Past 64 bits, the smallest operand doesn't change the sum.
+        const int64 shift = m_exponent - b.m_exponent;
+        if (shift > 64)
+        {
+            return *this;
+        }
+        if (shift < -64)
+        {
+            return b;
+        }
+        return shift >= 0 ? FloatExp(m_mantissa + std::ldexp(b.m_mantissa, -int(shift)), m_exponent)
+                          : FloatExp(std::ldexp(m_mantissa, int(shift)) + b.m_mantissa, b.m_exponent);
+    }
+    FloatExp operator-(const FloatExp &b) const { return *this + (-b); }
+
+    FloatExp &operator*=(const FloatExp &b) { return *this = *this * b; }
+    FloatExp &operator/=(const FloatExp &b) { return *this = *this / b; }
+    FloatExp &operator+=(const FloatExp &b) { return *this = *this + b; }
+    FloatExp &operator-=(const FloatExp &b) { return *this = *this - b; }
+
+    bool operator==(const FloatExp &b) const { return m_mantissa == b.m_mantissa && m_exponent == b.m_exponent; }
+    bool operator!=(const FloatExp &b) const { return !(*this == b); }
+    bool operator<(const FloatExp &b) const { return compare(b) < 0; }
+    bool operator>(const FloatExp &b) const { return compare(b) > 0; }
+    bool operator<=(const FloatExp &b) const { return compare(b) <= 0; }
+    bool operator>=(const FloatExp &b) const { return compare(b) >= 0; }
+
+    /// Decimal scientific notation, e.g. "1.5e-500"
+    std::string toString() const;
+
+    /// Parse a number in decimal scientific notation, with any exponent
+    static FloatExp fromString(const std::string &str);
+
+  private:
+    /// Bring the mantissa back to [0.5, 1)
+    void normalize()
+    {
+        int e = 0;
+        m_mantissa = std::frexp(m_mantissa, &e);
+        m_exponent = m_mantissa == 0.0 ? 0 : m_exponent + e;
+    }
+
+    /// -1, 0 or 1
+    int compare(const FloatExp &b) const
+    {
+        const bool negative = m_mantissa < 0.0;
+        if (negative != (b.m_mantissa < 0.0) || m_mantissa == 0.0 || b.m_mantissa == 0.0)
+        {
+            return m_mantissa < b.m_mantissa ? -1 : (m_mantissa > b.m_mantissa ? 1 : 0);
+        }
+        // Same sign, both non zero : the largest exponent has the largest magnitude
+        if (m_exponent != b.m_exponent)
+        {
+            return (m_exponent < b.m_exponent) != negative ? -1 : 1;
+        }
+        return m_mantissa < b.m_mantissa ? -1 : (m_mantissa > b.m_mantissa ? 1 : 0);
+    }
+
+  private:
+    double m_mantissa;
+    int64 m_exponent;
+};
+
+/// Square root of a non-negative FloatExp
+inline FloatExp sqrt(const FloatExp &x)
+{
+    // Make the exponent even : x = mantissa * 2^(2 half)
+    const int64 odd = x.getExponent() & 1;
+    return FloatExp(std::sqrt(std::ldexp(x.getMantissa(), int(odd))), (x.getExponent() - odd) / 2);
+}
+
+#endif // FLOATEXP_HPP_
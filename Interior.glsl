@@ -0,0 +1,61 @@
+// Early detection of points inside the Mandelbrot set, shared by the pixel shaders.
+// Each test can be switched on and off with a bit of the `features` uniform (see View.hpp)
+
+const uint FEATURE_SHAPE_CHECK = 1u; // Main cardioid and period-2 bulb test
+const uint FEATURE_PERIODICITY = 2u; // Orbit cycle detection
+const uint FEATURE_DERIVATIVE = 4u;  // Attracting cycle detection with the derivative
+
+// Periodicity detection : squared distance under which the orbit is considered back
+// to its checkpoint, a few ulps above the precision of each mode
+const float PERIODICITY_EPSILON_F = 1e-12;    // float
+const float PERIODICITY_EPSILON_FF = 1e-26;   // floatfloat
+const double PERIODICITY_EPSILON_D = 1e-28lf; // double
+const float PERIODICITY_EPSILON_QF = 1e-20;   // quadfloat, relative to the scale (squared)
+
+// Derivative detection : dz = dz_n/dz_1 is the product of the 2 z_k along the orbit. It tends to 0
+// when the orbit is attracted by a cycle, so c is in the set once |dz|^2 is below this. Escaping
+// orbits make it grow, so a few ulps of precision are enough : it is computed from the high parts.
+const float DERIVATIVE_EPSILON = 1e-12;
+
+// The escape loops run blocks of ESCAPE_UNROLL iterations without early exit : the escape and
+// periodicity tests of a block are only accumulated, and checked at its end. If one of them fired,
+// the block is rolled back and replayed one step at a time, which gives the exact iteration.
+const uint ESCAPE_UNROLL = 8u;
+
+// dz = 2 z dz, with z before the step
+vec2 derive(vec2 z, vec2 dz)
+{
+    return 2.0 * vec2(z.x * dz.x - z.y * dz.y, z.x * dz.y + z.y * dz.x);
+}
+
+dvec2 derive(dvec2 z, dvec2 dz)
+{
+    return 2.0 * dvec2(z.x * dz.x - z.y * dz.y, z.x * dz.y + z.y * dz.x);
+}
+
+// True if c is inside the main cardioid or the period-2 bulb, where the orbit never escapes.
+bool inMainCardioidOrBulb(vec2 c)
+{
+    float xq = c.x - 0.25;
+    float y2 = c.y * c.y;
+    float q = xq * xq + y2;
+    if (q * (q + xq) <= 0.25 * y2)
+    {
+        return true;
+    }
+    float xb = c.x + 1.0;
+    return xb * xb + y2 <= 0.0625;
+}
+
+bool inMainCardioidOrBulb(dvec2 c)
+{
+    double xq = c.x - 0.25;
+    double y2 = c.y * c.y;
+    double q = xq * xq + y2;
+    if (q * (q + xq) <= 0.25 * y2)
+    {
+        return true;
+    }
+    double xb = c.x + 1.0;
+    return xb * xb + y2 <= 0.0625;
+}
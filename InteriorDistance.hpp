@@ -0,0 +1,239 @@
+#ifndef INTERIORDISTANCE_HPP_
+#define INTERIORDISTANCE_HPP_
+
+// Interior distance estimation, used to prove that a whole region is inside the Mandelbrot set.
+// For a point c whose orbit is attracted by a cycle of period p, the estimate b satisfies
+// b/4 <= dist(c, boundary of the set) <= b (see "Interior distance estimation" in
+// A. Cheritat's notes, or the Mandelbrot page of the Wikibooks "Fractals").
+
+#include <CoreMacros.hpp>
+#include <complex>
+
+#include "EscapeKernels.hpp"
+#include "Perturbation.hpp"
+
+/// Return the interior distance estimate of c, or 0 if c could not be proven inside the set
+/// within maxIters iterations (escaping orbit, or cycle not found).
+inline double interiorDistance(double cx, double cy, uint maxIters)
+{
+    typedef std::complex<double> Complex;
+    const Complex c(cx, cy);
+
+    // Iterate until the orbit escapes or comes back close to its checkpoint (see escapeDouble())
+    PeriodicityCheckpoint checkpoint;
+    Complex z = c;
+    Complex check = z;
+    bool converged = false;
+    for (uint i = 0; i < maxIters && !converged; ++i)
+    {
+        z = z * z + c;
+        if (std::norm(z) > 4.0)
+        {
+            return 0.0;
+        }
+        converged = std::norm(z - check) < PERIODICITY_EPSILON_D;
+        if (!converged && checkpoint.advance())
+        {
+            check = z;
+        }
+    }
+    if (!converged)
+    {
+        return 0.0;
+    }
+
+    // The orbit is now on its cycle : the period is the first return to z
+    const uint maxPeriod = checkpoint.interval;
+    uint period = 0;
+    Complex w = z;
+    for (uint k = 1; k <= maxPeriod && period == 0; ++k)
+    {
+        w = w * w + c;
+        if (std::norm(w - z) < 1e-20)
+        {
+            period = k;
+        }
+    }
+    if (period == 0)
+    {
+        return 0.0;
+    }
+
+    // Refine the cycle point with Newton's method on f^p(z) - z
+    for (uint n = 0; n < 16; ++n)
+    {
+        Complex fz = z;
+        Complex dz = 1.0;
+        for (uint k = 0; k < period; ++k)
+        {
+            dz = 2.0 * fz * dz;
+            fz = fz * fz + c;
+        }
+        const Complex step = (fz - z) / (dz - 1.0);
+        z -= step;
+        if (std::norm(step) < 1e-30)
+        {
+            break;
+        }
+    }
+
+    // Derivatives of f^p along the cycle
+    Complex dz = 1.0;   // d/dz
+    Complex dc = 0.0;   // d/dc
+    Complex dzdz = 0.0; // d2/dz2
+    Complex dcdz = 0.0; // d2/dcdz
+    for (uint k = 0; k < period; ++k)
+    {
+        dcdz = 2.0 * (z * dcdz + dc * dz);
+        dzdz = 2.0 * (dz * dz + z * dzdz);
+        dc = 2.0 * z * dc + 1.0;
+        dz = 2.0 * z * dz;
+        z = z * z + c;
+    }
+
+    // The cycle must be attracting
+    const double multiplier = std::norm(dz);
+    if (!(multiplier < 1.0))
+    {
+        return 0.0;
+    }
+    const double denominator = std::abs(dcdz + dzdz * dc / (1.0 - dz));
+    if (!(denominator > 0.0))
+    {
+        return 0.0;
+    }
+    return (1.0 - multiplier) / denominator;
+}
+
+/// Point z = Z_m + d of an orbit iterated by perturbation of a reference orbit Z (see Perturbation.hpp)
+struct PerturbedPoint
+{
+    uint m;                 // index in the reference orbit
+    std::complex<double> d; // delta from the reference point
+};
+
+/// Same as interiorDistance(), for the pixel c = reference center + dc of a perturbation view (dc within
+/// the double range, see pixelDelta()). The orbit is iterated by perturbation, so c is known to the precision
+/// of dc rather than of c : the proof still holds past zooms of 1e-15. The orbit is rebased to z0 = 0 when
+/// the reference escapes, or when z gets closer to 0 than to the reference (where the delta would lose its
+/// precision). Points are compared on their deltas when they share their reference point, so cycles are
+/// resolved relative to their deltas, as escapePerturbation() does for periodicity.
+inline double perturbationInteriorDistance(double dcx, double dcy, uint maxIters, const ReferenceOrbit &ref)
+{
+    typedef std::complex<double> Complex;
+    const Complex c(dcx, dcy);
+    const uint last = ref.size() - 1;
+
+    auto value = [&ref](const PerturbedPoint &p) { return Complex(ref.x(p.m), ref.y(p.m)) + p.d; };
+    auto step = [&](PerturbedPoint &p) {
+        const Complex Z(ref.x(p.m), ref.y(p.m));
+        p.d = p.d * (2.0 * Z + p.d) + c;
+        ++p.m;
+        const Complex z = value(p);
+        if (p.m == last || std::norm(z) < std::norm(p.d))
+        {
+            p = PerturbedPoint{0, z};
+        }
+    };
+    // Squared distance between two points, and the tolerance on it (relative to the deltas when possible)
+    auto distance = [&](const PerturbedPoint &a, const PerturbedPoint &b, double epsilon, double &tolerance) {
+        if (a.m == b.m)
+        {
+            tolerance = epsilon * std::max(std::norm(a.d), std::norm(b.d));
+            return std::norm(a.d - b.d);
+        }
+        tolerance = epsilon;
+        return std::norm(value(a) - value(b));
+    };
+
+    // Iterate until the orbit escapes or comes back close to its checkpoint
+    PeriodicityCheckpoint checkpoint;
+    PerturbedPoint z{1, c};
+    PerturbedPoint check = z;
+    bool converged = false;
+    for (uint i = 0; i < maxIters && !converged; ++i)
+    {
+        step(z);
+        if (std::norm(value(z)) > 4.0)
+        {
+            return 0.0;
+        }
+        double tolerance;
+        converged = distance(z, check, PERIODICITY_EPSILON_D, tolerance) < tolerance;
+        if (!converged && checkpoint.advance())
+        {
+            check = z;
+        }
+    }
+    if (!converged)
+    {
+        return 0.0;
+    }
+
+    // The orbit is now on its cycle : the period is the first return to z
+    const uint maxPeriod = checkpoint.interval;
+    uint period = 0;
+    PerturbedPoint w = z;
+    for (uint k = 1; k <= maxPeriod && period == 0; ++k)
+    {
+        step(w);
+        double tolerance;
+        if (distance(w, z, 1e-20, tolerance) < tolerance)
+        {
+            period = k;
+        }
+    }
+    if (period == 0)
+    {
+        return 0.0;
+    }
+
+    // Refine the cycle point with Newton's method on f^p(z) - z
+    for (uint n = 0; n < 16; ++n)
+    {
+        PerturbedPoint fz = z;
+        Complex dz = 1.0;
+        for (uint k = 0; k < period; ++k)
+        {
+            dz = 2.0 * value(fz) * dz;
+            step(fz);
+        }
+        const Complex residual = fz.m == z.m ? fz.d - z.d : value(fz) - value(z);
+        const Complex change = residual / (dz - 1.0);
+        z.d -= change;
+        if (std::norm(change) <= 1e-30 * std::norm(z.d))
+        {
+            break;
+        }
+    }
+
+    // Derivatives of f^p along the cycle
+    Complex dz = 1.0;   // d/dz
+    Complex dc = 0.0;   // d/dc
+    Complex dzdz = 0.0; // d2/dz2
+    Complex dcdz = 0.0; // d2/dcdz
+    for (uint k = 0; k < period; ++k)
+    {
+        const Complex zk = value(z);
+        dcdz = 2.0 * (zk * dcdz + dc * dz);
+        dzdz = 2.0 * (dz * dz + zk * dzdz);
+        dc = 2.0 * zk * dc + 1.0;
+        dz = 2.0 * zk * dz;
+        step(z);
+    }
+
+    // The cycle must be attracting
+    const double multiplier = std::norm(dz);
+    if (!(multiplier < 1.0))
+    {
+        return 0.0;
+    }
+    const double denominator = std::abs(dcdz + dzdz * dc / (1.0 - dz));
+    if (!(denominator > 0.0))
+    {
+        return 0.0;
+    }
+    return (1.0 - multiplier) / denominator;
+}
+
+#endif // INTERIORDISTANCE_HPP_
@@ -0,0 +1,159 @@
+#ifndef ITERATIONFIELD_HPP_
+#define ITERATIONFIELD_HPP_
+
+#include <CoreMacros.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/// Rectangle of pixels [x0, x1) x [y0, y1) of a field, rows counted from the top
+struct PixelRect
+{
+    uint x0, y0, x1, y1;
+};
+
+/// Scroll the values of a w x h image : pixel (col, row) takes the value of pixel (col + dx, row + dy).
+/// The pixels left without a source keep their value.
+template <typename T>
+void scrollPixels(T *pixels, uint w, uint h, int dx, int dy)
+{
+    const uint shiftX = static_cast<uint>(std::abs(dx));
+    const uint shiftY = static_cast<uint>(std::abs(dy));
+    if (shiftX >= w || shiftY >= h)
+    {
+        return;
+    }
+
+    // Rows are moved in the order that reads each one before it is overwritten
+    const uint kept = w - shiftX;
+    const uint srcCol = dx > 0 ? shiftX : 0;
+    const uint dstCol = dx > 0 ? 0 : shiftX;
+    for (uint k = 0; k < h - shiftY; ++k)
+    {
+        const uint row = dy > 0 ? k : h - 1 - k;
+        const uint src = static_cast<uint>(int(row) + dy) * w + srcCol;
+        std::memmove(pixels + row * w + dstCol, pixels + src, kept * sizeof(T));
+    }
+}
+
+/// Zoom reprojection around the center of a w x h image whose scale is multiplied by `zoom` : the
+/// pixel of the previous image nearest to each pixel of the new one, as Reproject.glsl samples it.
+/// `error` is how far each value is from an exact one, in pixels (0 for computed values) : it's
+/// updated to the new pixels, adding the distance to the source, and is FLT_MAX without a source.
+inline std::vector<uint> reprojectZoom(uint w, uint h, double zoom, std::vector<float> &error)
+{
+    // Along an axis of n pixels : nearest source pixel of each pixel, and the squared distance to it
+    // (negative without a source)
+    struct Axis
+    {
+        std::vector<uint> nearest;
+        std::vector<double> distance2;
+
+        Axis(uint n, double zoom) : nearest(n), distance2(n)
+        {
+            for (uint i = 0; i < n; ++i)
+            {
+                const double pos = (2.0 * (i + 0.5)) / n - 1.0;
+                const double x = (pos * zoom + 1.0) * 0.5 * n - 0.5;
+                const double r = std::round(x);
+                nearest[i] = static_cast<uint>(std::min(std::max(r, 0.0), double(n - 1)));
+                distance2[i] = (x < -0.5 || x > n - 0.5) ? -1.0 : (x - r) * (x - r);
+            }
+        }
+    };
+    const Axis cols(w, zoom);
+    const Axis rows(h, zoom);
+
+    const std::vector<float> previous = error;
+    std::vector<uint> sources(w * h);
+    for (uint row = 0; row < h; ++row)
+    {
+        for (uint col = 0; col < w; ++col)
+        {
+            const uint n = row * w + col;
+            sources[n] = rows.nearest[row] * w + cols.nearest[col];
+            const float e = previous[sources[n]];
+            const bool outside = cols.distance2[col] < 0.0 || rows.distance2[row] < 0.0;
+            error[n] = (outside || e == FLT_MAX)
+                           ? FLT_MAX
+                           : static_cast<float>((e + std::sqrt(cols.distance2[col] + rows.distance2[row])) / zoom);
+        }
+    }
+    return sources;
+}
+
+/// Raw output of the escape-time computation for a whole frame, before coloring.
+/// Rows are stored top to bottom, like the images written by save_frame().
+struct IterationField
+{
+    uint width{0};
+    uint height{0};
+    uint maxIters{0};
+
+    std::vector<uint> iters;  // escape iteration per pixel (maxIters for points in the set)
+    std::vector<float> norms; // |z|^2 at escape per pixel
+
+    uint64 skippedIters{0};   // iterations skipped by the series approximation, summed over all pixels
+    uint glitchReferences{0}; // secondary perturbation references computed to fix glitches
+    uint unfixedGlitches{0};  // glitched pixels left after them, with the primary reference result
+
+    void resize(uint w, uint h, uint max)
+    {
+        width = w;
+        height = h;
+        maxIters = max;
+        iters.resize(w * h);
+        norms.resize(w * h);
+    }
+
+    /// Scroll the contents, for a view moved by whole pixels : pixel (col, row) takes the value of
+    /// pixel (col + dx, row + dy). Returns the pixels left without a value (see exposedPixels()).
+    std::vector<PixelRect> scroll(int dx, int dy)
+    {
+        scrollPixels(iters.data(), width, height, dx, dy);
+        scrollPixels(norms.data(), width, height, dx, dy);
+        return exposedPixels(width, height, dx, dy);
+    }
+
+    /// Pixel n takes the value of pixel sources[n], e.g. from reprojectZoom()
+    void gather(const std::vector<uint> &sources)
+    {
+        const std::vector<uint> previousIters = iters;
+        const std::vector<float> previousNorms = norms;
+        for (uint n = 0; n < sources.size(); ++n)
+        {
+            iters[n] = previousIters[sources[n]];
+            norms[n] = previousNorms[sources[n]];
+        }
+    }
+
+    /// Pixels of a w x h field scrolled by (dx, dy) that have no value : a strip of columns and a strip
+    /// of rows, or the whole field if nothing is left
+    static std::vector<PixelRect> exposedPixels(uint w, uint h, int dx, int dy)
+    {
+        const uint shiftX = static_cast<uint>(std::abs(dx));
+        const uint shiftY = static_cast<uint>(std::abs(dy));
+        if (shiftX >= w || shiftY >= h)
+        {
+            return {PixelRect{0, 0, w, h}};
+        }
+
+        std::vector<PixelRect> exposed;
+        const uint keptX0 = dx > 0 ? 0 : shiftX;
+        const uint keptX1 = keptX0 + w - shiftX;
+        if (shiftX > 0)
+        {
+            exposed.push_back(dx > 0 ? PixelRect{keptX1, 0, w, h} : PixelRect{0, 0, shiftX, h});
+        }
+        if (shiftY > 0)
+        {
+            exposed.push_back(dy > 0 ? PixelRect{keptX0, h - shiftY, keptX1, h} : PixelRect{keptX0, 0, keptX1, shiftY});
+        }
+        return exposed;
+    }
+};
+
+#endif // ITERATIONFIELD_HPP_
@@ -0,0 +1,105 @@
+#include "Palette.hpp"
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+/// Palette of BAKED_PALETTE_SIZE colors, color(u) for u in [0, 1) over the cycle
+template <typename F>
+Palette bake(const std::string &name, PaletteMapping mapping, float period, F color)
+{
+    Palette palette;
+    palette.name = name;
+    palette.mapping = mapping;
+    palette.period = period;
+    for (uint k = 0; k < BAKED_PALETTE_SIZE; ++k)
+    {
+        palette.colors.push_back(color(float(k) / float(BAKED_PALETTE_SIZE)));
+    }
+    return palette;
+}
+
+/// Cycle of the flashy scheme : 4 periods of its value, and about one of its hue
+const float FLASHY_PERIOD = 4.f * 2.f * 3.14159265f / 0.3f;
+} // namespace
+
+Palette builtinPalette(const std::string &name)
+{
+    if (name == "soft")
+    {
+        // The hue is the log of the smooth iteration count
+        return bake(name, PALETTE_LOG, 1.f, [](float u) { return HSVtoRGBA(u, 0.4f, 1.f); });
+    }
+    if (name == "flashy")
+    {
+        // colorRegulator increases linearly by 1 for every extra step it takes to break free.
+        return bake(name, PALETTE_LINEAR, FLASHY_PERIOD, [](float u) {
+            const float colorRegulator = u * FLASHY_PERIOD - 2.f;
+            return HSVtoRGBA(0.95f + .012f * colorRegulator, 1.0f, .2f + .4f * (1.0f + std::sin(.3f * colorRegulator)));
+        });
+    }
+    if (name == "blueyellow")
+    {
+        // Over the whole range of iterations
+        return bake(name, PALETTE_LINEAR, 0.f, [](float u) { return Rgba{u, u, 0.5f, 1.0f}; });
+    }
+    CORE_ASSERT(false, "Unknown palette " << name);
+    return Palette();
+}
+
+Palette loadPalette(const std::string &filename)
+{
+    std::ifstream in(filename);
+    CORE_ASSERT(in.good(), "Can't open " << filename);
+
+    Palette palette;
+    palette.name = filename;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string key;
+        if (!(words >> key))
+        {
+            continue;
+        }
+        if (key == "mapping")
+        {
+            std::string mapping;
+            words >> mapping;
+            CORE_ASSERT(mapping == "linear" || mapping == "log", "Unknown palette mapping " << mapping);
+            palette.mapping = mapping == "log" ? PALETTE_LOG : PALETTE_LINEAR;
+        }
+        else if (key == "period")
+        {
+            words >> palette.period;
+            CORE_ASSERT(!words.fail() && palette.period >= 0.f, "Invalid palette period in " << filename);
+        }
+        else if (key == "color")
+        {
+            Rgba c{0.f, 0.f, 0.f, 1.f};
+            words >> c.r >> c.g >> c.b;
+            CORE_ASSERT(!words.fail(), "Invalid color in " << filename);
+            palette.colors.push_back(c);
+        }
+        else
+        {
+            CORE_ASSERT(false, "Unknown palette entry " << key << " in " << filename);
+        }
+    }
+    CORE_ASSERT(!palette.colors.empty(), "No colors in " << filename);
+    return palette;
+}
+
+Palette findPalette(const std::string &name)
+{
+    for (const char *builtin : BUILTIN_PALETTES)
+    {
+        if (name == builtin)
+        {
+            return builtinPalette(name);
+        }
+    }
+    return loadPalette(name);
+}
@@ -0,0 +1,88 @@
+#ifndef PALETTE_HPP_
+#define PALETTE_HPP_
+
+#include <CoreMacros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "ColorSchemes.hpp"
+
+/// Palette coordinate of an escaped point
+enum PaletteMapping
+{
+    PALETTE_LINEAR = 0, // smooth iteration count
+    PALETTE_LOG,        // log of the smooth iteration count
+};
+
+/// A cycle of colors indexed by the smooth iteration count : coloring a pixel is an interpolation
+/// between two colors, instead of evaluating a color scheme. The built-in palettes are baked from
+/// the color schemes, others are loaded from palette files :
+///   # comment
+///   mapping linear|log   palette coordinate (default linear)
+///   period P             coordinate units per cycle of the palette, 0 for the max iterations (default 0)
+///   color R G B          one line per color, channels in [0, 1], at regular intervals over the cycle
+struct Palette
+{
+    std::string name;
+    PaletteMapping mapping{PALETTE_LINEAR};
+    float period{0.f};
+    std::vector<Rgba> colors;
+
+    /// Period in units of the coordinate, for a frame of maxIters iterations
+    float cycle(uint maxIters) const { return period > 0.f ? period : float(maxIters); }
+};
+
+/// Built-in palettes, the first one is the default
+const char *const BUILTIN_PALETTES[] = {"soft", "flashy", "blueyellow"};
+const uint BUILTIN_PALETTE_COUNT = sizeof(BUILTIN_PALETTES) / sizeof(BUILTIN_PALETTES[0]);
+
+/// Number of colors of the built-in palettes
+const uint BAKED_PALETTE_SIZE = 1024;
+
+/// Built-in palette baked from a color scheme, by name
+Palette builtinPalette(const std::string &name);
+
+/// Load a palette file
+Palette loadPalette(const std::string &filename);
+
+/// Built-in palette if `name` is one, palette file otherwise
+Palette findPalette(const std::string &name);
+
+/// Color at `x` cycles of the palette, paletteSample() of ColorSchemes.glsl : linear interpolation
+/// between the two nearest colors
+inline Rgba paletteSample(const Palette &palette, float x)
+{
+    const int size = static_cast<int>(palette.colors.size());
+    const float t = glsl_fract(x) * float(size);
+    const int k = std::min(static_cast<int>(t), size - 1);
+    const Rgba &a = palette.colors[k];
+    const Rgba &b = palette.colors[k + 1 < size ? k + 1 : 0];
+    const float w = t - float(k);
+    return Rgba{a.r + (b.r - a.r) * w, a.g + (b.g - a.g) * w, a.b + (b.b - a.b) * w, a.a + (b.a - a.a) * w};
+}
+
+/// Color of an escaped point, paletteColor() of ColorSchemes.glsl. `period` is palette.cycle() for
+/// the frame, `offset` shifts the palette, in cycles.
+inline Rgba paletteColor(const Palette &palette, float period, float offset, uint iters, float radius)
+{
+    // Same coordinate as the shader's blend of mu and log(mu), without the log when it's not used
+    const float mu = smoothIteration(iters, radius);
+    const float x = palette.mapping == PALETTE_LOG ? std::log(std::max(mu, 1e-3f)) : mu;
+    return paletteSample(palette, x / period + offset);
+}
+
+/// Histogram equalization, equalizedCoordinate() of ColorSchemes.glsl : fraction of the escaped
+/// pixels of the frame whose smooth iteration count is below this one's. `cdf[k]` is the fraction
+/// of them that escaped before iteration k (see CpuRenderer::equalization()), and is interpolated
+/// linearly in between, so the palette spreads evenly over the frame whatever the zoom.
+inline float equalizedCoordinate(const std::vector<float> &cdf, uint iters, float radius)
+{
+    const uint last = static_cast<uint>(cdf.size() - 1);
+    const float mu = std::min(std::max(smoothIteration(iters, radius), 0.f), float(last));
+    const uint k = std::min(static_cast<uint>(mu), last - 1);
+    return cdf[k] + (cdf[k + 1] - cdf[k]) * (mu - float(k));
+}
+
+#endif // PALETTE_HPP_
@@ -0,0 +1,289 @@
+#include "Perturbation.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "FixedPoint.hpp"
+
+namespace
+{
+/// Orbit of (cx, cy) with N fraction limbs, until it escapes or reaches maxIters iterations.
+/// z^2 is computed with squares only : 2 xy = (x + y)^2 - x^2 - y^2.
+template <uint N>
+void computeOrbit(const BigFixed &cx, const BigFixed &cy, uint maxIters, std::vector<double> &zx, std::vector<double> &zy)
+{
+    const FixedPoint<N> c0(cx);
+    const FixedPoint<N> c1(cy);
+    FixedPoint<N> x = c0;
+    FixedPoint<N> y = c1;
+    zx.push_back(x.toDouble());
+    zy.push_back(y.toDouble());
+
+    // A pixel at iteration i reads the point i + 2
+    while (zx.size() < maxIters + 2)
+    {
+        const FixedPoint<N> x2 = x.square();
+        const FixedPoint<N> y2 = y.square();
+        const FixedPoint<N> s2 = (x + y).square();
+        x = x2 - y2 + c0;
+        y = s2 - x2 - y2 + c1;
+
+        const double dx = x.toDouble();
+        const double dy = y.toDouble();
+        zx.push_back(dx);
+        zy.push_back(dy);
+        if (dx * dx + dy * dy > 4.0)
+        {
+            break;
+        }
+    }
+}
+
+/// Call computeOrbit() with the smallest instantiated limb count >= limbs
+template <uint N, uint... Larger>
+struct OrbitDispatch
+{
+    static bool run(uint limbs, const BigFixed &cx, const BigFixed &cy, uint maxIters, std::vector<double> &zx,
+                    std::vector<double> &zy)
+    {
+        if (limbs <= N)
+        {
+            computeOrbit<N>(cx, cy, maxIters, zx, zy);
+            return true;
+        }
+        return OrbitDispatch<Larger...>::run(limbs, cx, cy, maxIters, zx, zy);
+    }
+};
+
+template <uint N>
+struct OrbitDispatch<N>
+{
+    static bool run(uint limbs, const BigFixed &cx, const BigFixed &cy, uint maxIters, std::vector<double> &zx,
+                    std::vector<double> &zy)
+    {
+        if (limbs <= N)
+        {
+            computeOrbit<N>(cx, cy, maxIters, zx, zy);
+            return true;
+        }
+        return false;
+    }
+};
+
+// Instantiated precisions : steps of 1.5x, up to 32768 bits (zooms to about 1e-9800)
+typedef OrbitDispatch<2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024> OrbitPrecisions;
+} // namespace
+
+ReferenceOrbit::ReferenceOrbit(const BigFixed &cx, const BigFixed &cy, uint maxIters, uint fractionLimbs)
+{
+    // z0 = 0, z1 = c
+    m_x.reserve(maxIters + 2);
+    m_y.reserve(maxIters + 2);
+    m_x.push_back(0.0);
+    m_y.push_back(0.0);
+    if (OrbitPrecisions::run(fractionLimbs, cx, cy, maxIters, m_x, m_y))
+    {
+        return;
+    }
+
+    // Beyond the instantiated precisions, iterate with BigFixed
+    BigFixed x = cx;
+    BigFixed y = cy;
+    x.setFractionLimbs(fractionLimbs);
+    y.setFractionLimbs(fractionLimbs);
+    const BigFixed c0 = x;
+    const BigFixed c1 = y;
+    m_x.push_back(x.toDouble());
+    m_y.push_back(y.toDouble());
+    while (m_x.size() < maxIters + 2)
+    {
+        const BigFixed xy = x * y;
+        x = x * x - y * y + c0;
+        y = xy + xy + c1;
+
+        const double zx = x.toDouble();
+        const double zy = y.toDouble();
+        m_x.push_back(zx);
+        m_y.push_back(zy);
+        if (zx * zx + zy * zy > 4.0)
+        {
+            break;
+        }
+    }
+}
+
+namespace
+{
+// Error allowed between the series and the iterated delta of a probe, relative to the distance
+// between the deltas of two neighbouring pixels (derivative times pixel size)
+const double SERIES_TOLERANCE = 1e-9;
+} // namespace
+
+SeriesApproximation::SeriesApproximation(const ReferenceOrbit &ref, uint terms, uint maxIters, double pixelSize,
+                                         const std::vector<double> &probeX, const std::vector<double> &probeY,
+                                         const FloatExp &unit)
+    : m_terms(terms), m_radius(0.0), m_valid(probeX.size(), 1u)
+{
+    CORE_ASSERT(terms > 0, "Empty series");
+    CORE_ASSERT(probeX.size() == probeY.size(), "Inconsistent probes");
+    const uint probes = uint(probeX.size());
+    for (uint p = 0; p < probes; ++p)
+    {
+        m_radius = std::max(m_radius, std::hypot(probeX[p], probeY[p]));
+    }
+    if (m_radius == 0.0)
+    {
+        return;
+    }
+
+    // Scaled coefficients D_k = A_k radius^k / unit, so that dz / unit = sum(D_k (dc / radius)^k) :
+    //     D_1' = 2 Z D_1 + radius / unit, D_k' = 2 Z D_k + unit sum(D_j D_k-j)
+    const double unitValue = unit.toDouble();
+
+    // dz1 = dc : A_1 = 1 (scaled : radius), the other terms are 0
+    std::vector<double> ax(terms, 0.0);
+    std::vector<double> ay(terms, 0.0);
+    ax[0] = m_radius;
+    m_coefX = ax;
+    m_coefY = ay;
+
+    // Deltas of the probes, iterated as the pixels would
+    std::vector<double> dx(probeX);
+    std::vector<double> dy(probeY);
+    std::vector<bool> failed(probes, false);
+    uint running = probes;
+
+    // Stop one point before the end of the reference, where the pixels need to rebase
+    const uint last = std::min(ref.size() - 2, maxIters);
+    for (uint n = 1; n < last && running > 0; ++n)
+    {
+        // A_1' = 2 Z A_1 + 1, A_k' = 2 Z A_k + sum(A_j A_k-j)
+        const double zx = ref.x(n);
+        const double zy = ref.y(n);
+        std::vector<double> bx(terms);
+        std::vector<double> by(terms);
+        for (uint k = 0; k < terms; ++k)
+        {
+            double sx = 0.0;
+            double sy = 0.0;
+            for (uint j = 0; j + 1 <= k; ++j)
+            {
+                sx += ax[j] * ax[k - 1 - j] - ay[j] * ay[k - 1 - j];
+                sy += ax[j] * ay[k - 1 - j] + ay[j] * ax[k - 1 - j];
+            }
+            bx[k] = 2.0 * (zx * ax[k] - zy * ay[k]) + unitValue * sx;
+            by[k] = 2.0 * (zx * ay[k] + zy * ax[k]) + unitValue * sy;
+        }
+        bx[0] += m_radius;
+        ax.swap(bx);
+        ay.swap(by);
+        m_coefX.insert(m_coefX.end(), ax.begin(), ax.end());
+        m_coefY.insert(m_coefY.end(), ay.begin(), ay.end());
+
+        // A_1 dc is the linear part of the delta (the coefficients are scaled by the radius)
+        const double pixelStep = pixelSize / m_radius;
+        const double maxError = SERIES_TOLERANCE * SERIES_TOLERANCE * (ax[0] * ax[0] + ay[0] * ay[0]) * pixelStep * pixelStep;
+
+        // The probes still matching the series at n + 1 can skip up to there
+        for (uint p = 0; p < probes; ++p)
+        {
+            if (failed[p])
+            {
+                continue;
+            }
+            scaledPerturbationStep(zx, zy, probeX[p], probeY[p], unitValue, dx[p], dy[p]);
+
+            double sx, sy;
+            evaluate(n + 1, probeX[p], probeY[p], sx, sy);
+            const double ex = sx - dx[p];
+            const double ey = sy - dy[p];
+            const double x = ref.x(n + 1) + dx[p] * unitValue;
+            const double y = ref.y(n + 1) + dy[p] * unitValue;
+            const double norm = dx[p] * dx[p] + dy[p] * dy[p];
+            // The pixels rescale their deltas from there, as long as they are still finite
+            if (x * x + y * y > 4.0 || !std::isfinite(norm) || !(ex * ex + ey * ey <= maxError))
+            {
+                failed[p] = true;
+                --running;
+            }
+            else
+            {
+                m_valid[p] = n + 1;
+            }
+        }
+    }
+}
+
+void SeriesApproximation::evaluate(uint n, double dcx, double dcy, double &dx, double &dy) const
+{
+    CORE_ASSERT(n >= 1 && n * m_terms <= m_coefX.size(), "Series not computed up to " << n);
+    const double *cx = &m_coefX[(n - 1) * m_terms];
+    const double *cy = &m_coefY[(n - 1) * m_terms];
+
+    // Horner scheme in u = dc / radius
+    const double ux = dcx / m_radius;
+    const double uy = dcy / m_radius;
+    double sx = cx[m_terms - 1];
+    double sy = cy[m_terms - 1];
+    for (uint k = m_terms - 1; k-- > 0;)
+    {
+        const double tx = sx * ux - sy * uy + cx[k];
+        const double ty = sx * uy + sy * ux + cy[k];
+        sx = tx;
+        sy = ty;
+    }
+    dx = sx * ux - sy * uy;
+    dy = sx * uy + sy * ux;
+}
+
+BlaTable::BlaTable(const ReferenceOrbit &ref, const FloatExp &dcMax)
+{
+    // Level 0 : single steps from the points 1 .. last - 1 (the last one is where the pixels rebase).
+    // dz' = 2 Z dz + dc, neglecting dz^2 which is below the precision while |dz| < eps |2 Z|
+    const uint steps = ref.size() >= 2 ? ref.size() - 2 : 0;
+    std::vector<Bla> level(steps);
+    for (uint j = 0; j < steps; ++j)
+    {
+        const double ax = 2.0 * ref.x(j + 1);
+        const double ay = 2.0 * ref.y(j + 1);
+        const FloatExp radius = DBL_EPSILON * std::hypot(ax, ay);
+        level[j] = Bla{ax, ay, 1.0, 0.0, (radius * radius).toDouble(), radius * radius};
+    }
+
+    // Level l + 1 : x then y, two consecutive approximations of level l
+    //     A = Ay Ax, B = Ay Bx + By, radius = min(rx, (ry - |Bx| dcMax) / |Ax|)
+    // The radii are computed as FloatExp, since they can be far below the double range.
+    while (level.size() >= 2)
+    {
+        std::vector<Bla> merged(level.size() / 2);
+        for (uint j = 0; j < merged.size(); ++j)
+        {
+            const Bla &x = level[2 * j];
+            const Bla &y = level[2 * j + 1];
+            const double normAx = std::hypot(x.ax, x.ay);
+            const double normBx = std::hypot(x.bx, x.by);
+            FloatExp radius;
+            if (normAx > 0.0 && std::isfinite(normAx) && std::isfinite(normBx))
+            {
+                const FloatExp ry = sqrt(y.deepRadius2) - FloatExp(normBx) * dcMax;
+                radius = std::min(sqrt(x.deepRadius2), ry > FloatExp() ? ry / FloatExp(normAx) : FloatExp());
+            }
+
+            merged[j].ax = y.ax * x.ax - y.ay * x.ay;
+            merged[j].ay = y.ax * x.ay + y.ay * x.ax;
+            merged[j].bx = y.ax * x.bx - y.ay * x.by + y.bx;
+            merged[j].by = y.ax * x.by + y.ay * x.bx + y.by;
+            if (!std::isfinite(std::hypot(merged[j].ax, merged[j].ay)) ||
+                !std::isfinite(std::hypot(merged[j].bx, merged[j].by)))
+            {
+                radius = FloatExp(); // Overflow : the approximation can't be used
+            }
+            merged[j].radius2 = (radius * radius).toDouble();
+            merged[j].deepRadius2 = radius * radius;
+        }
+        m_levels.push_back(std::move(level));
+        level = std::move(merged);
+    }
+    m_levels.push_back(std::move(level));
+}
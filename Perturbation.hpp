@@ -0,0 +1,427 @@
+#ifndef PERTURBATION_HPP_
+#define PERTURBATION_HPP_
+
+// Perturbation rendering for deep zooms. One reference orbit Z is computed at the view
+// center with arbitrary precision. Each pixel c = C + dc then only iterates its difference
+// with the reference, dz = z - Z, in hardware double :
+//     dz' = 2 Z dz + dz^2 + dc
+// which stays accurate however small dc is, since it never adds small numbers to large ones.
+// Past the double range (zooms below 1e-290), the deltas are stored in units of the view scale,
+// and each pixel rescales its own unit as dz grows (see FloatExp).
+
+#include <CoreMacros.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "View.hpp"
+#include "BigFixed.hpp"
+#include "EscapeKernels.hpp"
+
+/// Orbit of the view center, computed with arbitrary precision and stored as doubles
+class ReferenceOrbit
+{
+  public:
+    /// Compute the orbit of (cx, cy) with the given number of fraction limbs,
+    /// until it escapes or reaches maxIters iterations
+    ReferenceOrbit(const BigFixed &cx, const BigFixed &cy, uint maxIters, uint fractionLimbs);
+
+    /// Number of stored points. Point 0 is z0 = 0, point 1 is z1 = c...
+    uint size() const { return uint(m_x.size()); }
+
+    double x(uint n) const { return m_x[n]; }
+    double y(uint n) const { return m_y[n]; }
+
+    /// Reference point, rounded to double
+    double centerX() const { return m_x[1]; }
+    double centerY() const { return m_y[1]; }
+
+  private:
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+};
+
+/// Truncated Taylor series of the pixel deltas along the reference orbit :
+///     dz_n = A_1,n dc + A_2,n dc^2 + ... + A_K,n dc^K
+/// The coefficients only depend on the reference, so all the pixels of a region where the series
+/// holds can jump to iteration n at once. Its validity is checked on probe points (tile corners) :
+/// the error is a holomorphic function of dc, so it is largest on the border of the region.
+class SeriesApproximation
+{
+  public:
+    /// Compute the coefficients of a series with the given number of terms, and for each probe
+    /// (dc = probeX[p], probeY[p]) the number of iterations it can skip, with an error well below
+    /// the distance between two pixels of the given size
+    /// The deltas and the pixel size are in units of `unit` (see deltaUnit()).
+    SeriesApproximation(const ReferenceOrbit &ref, uint terms, uint maxIters, double pixelSize,
+                        const std::vector<double> &probeX, const std::vector<double> &probeY, const FloatExp &unit);
+
+    /// Iteration up to which the series matches the perturbation iterations of probe p
+    /// (dz_n can be evaluated for n <= getValidIterations(p), 1 means no skipping)
+    uint getValidIterations(uint p) const { return m_valid[p]; }
+
+    /// Evaluate dz_n at dc
+    void evaluate(uint n, double dcx, double dcy, double &dx, double &dy) const;
+
+  private:
+    uint m_terms;
+    double m_radius; // The coefficients are scaled by radius^k / unit, to keep them in double range
+
+    std::vector<double> m_coefX; // Coefficients of iteration n at [(n - 1) * terms + k - 1]
+    std::vector<double> m_coefY;
+    std::vector<uint> m_valid;
+};
+
+/// Bilinear approximation of a run of perturbation steps starting at some reference point :
+///     dz_m+l = A dz_m + B dc
+/// valid while |dz_m| < radius, where the dz^2 terms are below the double precision.
+struct Bla
+{
+    double ax, ay; // A (complex)
+    double bx, by; // B (complex)
+    double radius2; // squared validity radius
+    FloatExp deepRadius2; // same, for the deltas beyond the double range
+};
+
+/// Hierarchical table of bilinear approximations along a reference orbit : level l holds
+/// the approximations of the 2^l steps starting at the reference points 1 + j 2^l.
+/// It only depends on the reference and the frame size, so it is built once and shared by all threads.
+class BlaTable
+{
+  public:
+    /// Build the table for pixels with |dc| <= dcMax
+    BlaTable(const ReferenceOrbit &ref, const FloatExp &dcMax);
+
+    /// Longest approximation (at least 2 steps, at most maxSteps) starting at the reference point m
+    /// and valid for a delta of squared norm dzNorm, or nullptr if single steps must be used.
+    /// The number of steps is returned in `steps`.
+    const Bla *lookup(uint m, double dzNorm, uint maxSteps, uint &steps) const
+    {
+        return find(m, maxSteps, steps, [dzNorm](const Bla &b) { return dzNorm < b.radius2; });
+    }
+
+    /// Same, for a delta beyond the double range
+    const Bla *lookupDeep(uint m, const FloatExp &dzNorm, uint maxSteps, uint &steps) const
+    {
+        return find(m, maxSteps, steps, [&dzNorm](const Bla &b) { return dzNorm < b.deepRadius2; });
+    }
+
+  private:
+    template <typename Valid>
+    const Bla *find(uint m, uint maxSteps, uint &steps, const Valid &valid) const
+    {
+        // A level's radius is at most the radius of its first half : stop at the first invalid level
+        const Bla *found = nullptr;
+        const uint offset = m - 1;
+        for (uint l = 1; m > 0 && l < m_levels.size(); ++l)
+        {
+            const uint length = 1u << l;
+            const uint j = offset >> l;
+            if ((offset & (length - 1)) != 0 || length > maxSteps || j >= m_levels[l].size() ||
+                !valid(m_levels[l][j]))
+            {
+                break;
+            }
+            found = &m_levels[l][j];
+            steps = length;
+        }
+        return found;
+    }
+
+  private:
+    std::vector<std::vector<Bla>> m_levels;
+};
+
+/// Zooms deeper than this store the deltas in units of the view scale, since they would underflow
+const double DEEP_ZOOM_SCALE = 1e-290;
+
+/// Whether the view is beyond the double range (view.scale is then rounded or flushed to zero)
+inline bool isDeepZoom(const View &view)
+{
+    return view.scale < DEEP_ZOOM_SCALE;
+}
+
+/// Unit of the deltas dc and dz of a frame : 1 within the double range, the view scale beyond
+inline FloatExp deltaUnit(const View &view)
+{
+    return isDeepZoom(view) ? view.preciseScale : FloatExp(1.0);
+}
+
+/// Offset dc of the pixel at pixelPosition() `pos` from the center point, in delta units, rounded as the other kernels do
+inline void pixelDelta(float posX, float posY, const View &view, double &dcx, double &dcy)
+{
+    const double scale = isDeepZoom(view) ? 1.0 : view.scale;
+    dcx = static_cast<double>(posX) * pixelWidth(view, scale);
+    dcy = static_cast<double>(posY) * pixelHeight(view, scale);
+}
+
+/// One perturbation step : dz' = 2 Z dz + dz^2 + dc
+inline void perturbationStep(double zx, double zy, double dcx, double dcy, double &dx, double &dy)
+{
+    const double ndx = 2.0 * (zx * dx - zy * dy) + (dx * dx - dy * dy) + dcx;
+    const double ndy = 2.0 * (zx * dy + zy * dx) + 2.0 * dx * dy + dcy;
+    dx = ndx;
+    dy = ndy;
+}
+
+/// Same step on deltas in units of `unit` (w = dz / unit, u = dc / unit) : w' = 2 Z w + unit w^2 + u
+inline void scaledPerturbationStep(double zx, double zy, double ux, double uy, double unit, double &wx, double &wy)
+{
+    const double nwx = 2.0 * (zx * wx - zy * wy) + unit * (wx * wx - wy * wy) + ux;
+    const double nwy = 2.0 * (zx * wy + zy * wx) + unit * (2.0 * wx * wy) + uy;
+    wx = nwx;
+    wy = nwy;
+}
+
+/// Run of steps replaced by a bilinear approximation : dz = A dz + B dc
+inline void blaStep(const Bla &approx, double dcx, double dcy, double &dx, double &dy)
+{
+    const double ndx = approx.ax * dx - approx.ay * dy + (approx.bx * dcx - approx.by * dcy);
+    const double ndy = approx.ax * dy + approx.ay * dx + (approx.bx * dcy + approx.by * dcx);
+    dx = ndx;
+    dy = ndy;
+}
+
+/// Deltas beyond the double range are rescaled when |w|^2 exceeds this, by 2^-DEEP_RESCALE_BITS...
+const double DEEP_RESCALE_NORM = 1.3407807929942597e154; // 2^512
+const int DEEP_RESCALE_BITS = 256;
+/// ...until their unit is large enough for plain doubles
+const int64 DEEP_EXIT_EXPONENT = -600;
+
+/// Iteration result of a pixel whose delta lost its precision (Pauldelbrot's criterion :
+/// |Z + dz| much smaller than |Z|). It must be computed again with a reference closer to it.
+/// The norm then holds |Z + dz|^2 / |Z|^2 : the glitch is centered where it is smallest.
+const uint GLITCHED_PIXEL = ~0u;
+const double GLITCH_TOLERANCE = 1e-6; // on |Z + dz|^2 / |Z|^2
+
+/// A reference orbit and its acceleration structures, as used by the pixels
+struct PerturbationReference
+{
+    const ReferenceOrbit *orbit{nullptr};
+    const BlaTable *bla{nullptr};               // Optional
+    const SeriesApproximation *series{nullptr}; // Optional, for the primary reference only
+    double offsetX{0.0};                        // dc of the reference point from the view center
+    double offsetY{0.0};
+    FloatExp unit{1.0};                         // Unit of the offset and the deltas (see deltaUnit())
+    bool detectGlitches{true};
+};
+
+/// First iterations of a pixel of escapePerturbation() beyond the double range : w = dz / unit,
+/// with a unit of the pixel's own, which grows by powers of 2 along with dz. Escape, glitches and
+/// periodicity can't happen while dz is that small. Returns false when the pixel is done (result is set),
+/// otherwise dz and dc are converted to plain doubles for the rest of the iterations.
+inline bool iterateDeepDelta(const View &view, const PerturbationReference &reference, double &dcx, double &dcy,
+                             double &dx, double &dy, uint &m, uint &i, EscapeResult &result)
+{
+    const ReferenceOrbit &ref = *reference.orbit;
+    const uint last = ref.size() - 1;
+    FloatExp unit = reference.unit;
+    FloatExp unit2 = unit * unit;
+    double unitValue = unit.toDouble();
+
+    // Move 2^DEEP_RESCALE_BITS from the deltas to the unit. Once the unit is large enough,
+    // convert the deltas to plain doubles and return true.
+    auto rescale = [&]() {
+        dx = std::ldexp(dx, -DEEP_RESCALE_BITS);
+        dy = std::ldexp(dy, -DEEP_RESCALE_BITS);
+        dcx = std::ldexp(dcx, -DEEP_RESCALE_BITS);
+        dcy = std::ldexp(dcy, -DEEP_RESCALE_BITS);
+        unit = unit.ldexp(DEEP_RESCALE_BITS);
+        unit2 = unit * unit;
+        unitValue = unit.toDouble();
+        if (unit.getExponent() <= DEEP_EXIT_EXPONENT)
+        {
+            return false;
+        }
+        dx *= unitValue;
+        dy *= unitValue;
+        dcx *= unitValue;
+        dcy *= unitValue;
+        return true;
+    };
+
+    while (i < view.iters)
+    {
+        uint steps = 1;
+        const Bla *approx =
+            reference.bla ? reference.bla->lookupDeep(m, FloatExp(dx * dx + dy * dy) * unit2, view.iters - i, steps) : nullptr;
+        if (approx)
+        {
+            // A dz stays small, but A w can overflow : rescale until it fits
+            double ndx = dx;
+            double ndy = dy;
+            while (blaStep(*approx, dcx, dcy, ndx, ndy), !std::isfinite(ndx * ndx + ndy * ndy))
+            {
+                if (rescale())
+                {
+                    return true;
+                }
+                ndx = dx;
+                ndy = dy;
+            }
+            dx = ndx;
+            dy = ndy;
+        }
+        else
+        {
+            scaledPerturbationStep(ref.x(m), ref.y(m), dcx, dcy, unitValue, dx, dy);
+        }
+        m += steps;
+        i += steps;
+
+        // The reference escaped, and this pixel with it since dz is negligible
+        if (m == last)
+        {
+            const double norm = ref.x(m) * ref.x(m) + ref.y(m) * ref.y(m);
+            result = EscapeResult{i - 1, static_cast<float>(norm)};
+            return false;
+        }
+
+        if (dx * dx + dy * dy > DEEP_RESCALE_NORM && rescale())
+        {
+            return true;
+        }
+    }
+    result = EscapeResult{view.iters, 0.f};
+    return false;
+}
+
+/// Escape-time iteration of the pixel at `pos` by perturbation of the reference orbit,
+/// with the same iteration numbering as escapeDouble().
+/// With a series, the first `skip` iterations are replaced by its evaluation. With a BLA table,
+/// runs of steps are replaced by a single approximation when the delta is small enough.
+inline EscapeResult escapePerturbation(float posX, float posY, const View &view, const PerturbationReference &reference,
+                                       uint skip = 1)
+{
+    const ReferenceOrbit &ref = *reference.orbit;
+    const BlaTable *bla = reference.bla;
+    const SeriesApproximation *series = reference.series;
+
+    double dcx, dcy;
+    pixelDelta(posX, posY, view, dcx, dcy);
+    dcx -= reference.offsetX;
+    dcy -= reference.offsetY;
+
+    const double unit = reference.unit.toDouble();
+    if ((view.features & FEATURE_SHAPE_CHECK) &&
+        inMainCardioidOrBulb(ref.centerX() + dcx * unit, ref.centerY() + dcy * unit))
+    {
+        return EscapeResult{view.iters, 0.f};
+    }
+
+    // Periodicity is checked on the deltas, since z itself can't resolve distances below 1e-16 :
+    // the orbit is back to its checkpoint when the reference is (exactly, in double) and dz is too,
+    // relative to the size of the view.
+    const bool periodicity = (view.features & FEATURE_PERIODICITY) != 0;
+    const double periodicityEpsilon = PERIODICITY_EPSILON_D * std::min(1.0, view.scale * view.scale);
+
+    // The derivative dz_n/dz_k doesn't depend on the scale : it is tracked in double from the first
+    // iteration done in double (k), which detects attracting cycles as well as dz_n/dz_1
+    const bool derivative = (view.features & FEATURE_DERIVATIVE) != 0;
+    double dzx = 1.0;
+    double dzy = 0.0;
+
+    // z1 = c, so dz1 = dc
+    double dx = dcx;
+    double dy = dcy;
+    uint m = 1; // index in the reference orbit
+    if (series && skip > 1)
+    {
+        series->evaluate(skip, dcx, dcy, dx, dy);
+        m = skip;
+    }
+
+    uint i = m - 1;
+    EscapeResult result;
+    if (unit != 1.0 && !iterateDeepDelta(view, reference, dcx, dcy, dx, dy, m, i, result))
+    {
+        return result;
+    }
+
+    PeriodicityCheckpoint checkpoint;
+    double checkZx = ref.x(m);
+    double checkZy = ref.y(m);
+    double checkDx = dx;
+    double checkDy = dy;
+
+    const uint last = ref.size() - 1;
+    for (; i < view.iters; ++i)
+    {
+        uint steps = 1;
+        const Bla *approx = bla ? bla->lookup(m, dx * dx + dy * dy, view.iters - i, steps) : nullptr;
+        if (approx)
+        {
+            if (derivative)
+            {
+                // Within its validity radius, A is the derivative of the steps : dz = A dz
+                const double ndzx = approx->ax * dzx - approx->ay * dzy;
+                dzy = approx->ax * dzy + approx->ay * dzx;
+                dzx = ndzx;
+            }
+            // Continue as if the last of the steps had just been done
+            blaStep(*approx, dcx, dcy, dx, dy);
+            m += steps;
+            i += steps - 1;
+        }
+        else
+        {
+            if (derivative)
+            {
+                // dz = 2 z dz
+                const double zx = ref.x(m) + dx;
+                const double zy = ref.y(m) + dy;
+                const double ndzx = 2.0 * (zx * dzx - zy * dzy);
+                dzy = 2.0 * (zx * dzy + zy * dzx);
+                dzx = ndzx;
+            }
+            perturbationStep(ref.x(m), ref.y(m), dcx, dcy, dx, dy);
+            ++m;
+        }
+
+        const double x = ref.x(m) + dx;
+        const double y = ref.y(m) + dy;
+        const double norm = x * x + y * y;
+        if (norm > 4.0)
+        {
+            return EscapeResult{i, static_cast<float>(norm)};
+        }
+
+        const double refNorm = ref.x(m) * ref.x(m) + ref.y(m) * ref.y(m);
+        if (reference.detectGlitches && norm < GLITCH_TOLERANCE * refNorm)
+        {
+            return EscapeResult{GLITCHED_PIXEL, static_cast<float>(norm / refNorm)};
+        }
+
+        if (periodicity)
+        {
+            const double px = dx - checkDx;
+            const double py = dy - checkDy;
+            if (ref.x(m) == checkZx && ref.y(m) == checkZy && px * px + py * py < periodicityEpsilon)
+            {
+                break; // The orbit is periodic, c is in the set
+            }
+            if (checkpoint.advance())
+            {
+                checkZx = ref.x(m);
+                checkZy = ref.y(m);
+                checkDx = dx;
+                checkDy = dy;
+            }
+        }
+
+        if (derivative && dzx * dzx + dzy * dzy < static_cast<double>(DERIVATIVE_EPSILON))
+        {
+            break; // The orbit converges to a cycle, c is in the set
+        }
+
+        // The reference escaped before this pixel : continue from z0 = 0, where dz = z
+        if (m == last)
+        {
+            dx = x;
+            dy = y;
+            m = 0;
+        }
+    }
+    return EscapeResult{view.iters, 0.f};
+}
+
+#endif // PERTURBATION_HPP_
@@ -1,30 +1,119 @@
 #version 420 core
-#include <ColorSchemes.glsl>
+#include <Interior.glsl>
 
-in vec2 pos;
-out vec4 FragColor;
+out vec2 FragField; // iteration at escape (max for points in the set) and |z|^2, colored by Color.glsl
 
 uniform dvec2 center = dvec2(-0.5,0);
-uniform double scale = 2.0;
-uniform float ratio = 1.0;
+uniform dvec2 pixel = dvec2(0.005); // size of a pixel
+uniform vec2 offset = vec2(-400,-400); // pixel positions from the center point are gl_FragCoord + offset (see pixelPosition())
 uniform uint max = 1000u;
+uniform uint features = FEATURE_SHAPE_CHECK | FEATURE_PERIODICITY | FEATURE_DERIVATIVE;
+
+// z = z^2 + c
+dvec2 mandelbrotStep(dvec2 p, dvec2 c)
+{
+    return dvec2(p.x * p.x - p.y * p.y, 2.0 * p.x * p.y) + c;
+}
 
 void main()
 {
-    dvec2 p =  dvec2(pos) * dvec2(scale*ratio, scale) + center;
+    dvec2 p = dvec2(gl_FragCoord.xy + offset) * pixel + center;
     dvec2 c = p;
-    vec4 color = vec4(0,0,0,0);
-    for(uint i = 0u; i < max; i++)
+    vec2 field = vec2(float(max), 0.0);
+    if ((features & FEATURE_SHAPE_CHECK) != 0u && inMainCardioidOrBulb(c))
+    {
+        FragField = field;
+        return;
+    }
+
+    // Brent's cycle detection : the checkpoint moves to the current point after 1, 2, 4, 8... iterations
+    dvec2 checkpoint = p;
+    uint checkpointInterval = 1u;
+    uint sinceCheckpoint = 0u;
+
+    // Derivative detection (see Interior.glsl)
+    dvec2 dz = dvec2(1.0, 0.0);
+
+    // Blocks of ESCAPE_UNROLL iterations, tested at their end (see Interior.glsl)
+    uint i = 0u;
+    while (i + ESCAPE_UNROLL <= max)
+    {
+        dvec2 savedP = p;
+        dvec2 savedCheckpoint = checkpoint;
+        uint savedInterval = checkpointInterval;
+        uint savedSince = sinceCheckpoint;
+        dvec2 savedDz = dz;
+        bool stop = false;
+        for (uint k = 0u; k < ESCAPE_UNROLL; k++)
+        {
+            if ((features & FEATURE_DERIVATIVE) != 0u)
+            {
+                dz = derive(p, dz);
+            }
+            p = mandelbrotStep(p, c);
+            stop = stop || dot(p,p) > 4.0;
+            if ((features & FEATURE_PERIODICITY) != 0u)
+            {
+                dvec2 d = p - checkpoint;
+                stop = stop || dot(d,d) < PERIODICITY_EPSILON_D;
+                if (++sinceCheckpoint == checkpointInterval)
+                {
+                    checkpoint = p;
+                    sinceCheckpoint = 0u;
+                    checkpointInterval *= 2u;
+                }
+            }
+            stop = stop || ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON);
+        }
+        if (stop)
+        {
+            p = savedP;
+            checkpoint = savedCheckpoint;
+            checkpointInterval = savedInterval;
+            sinceCheckpoint = savedSince;
+            dz = savedDz;
+            break;
+        }
+        i += ESCAPE_UNROLL;
+    }
+
+    // Step by step : the block where the orbit stopped, or the last iterations
+    for(; i < max; i++)
     {
+        if ((features & FEATURE_DERIVATIVE) != 0u)
+        {
+            dz = derive(p, dz);
+        }
+
         //Perform complex number arithmetic
-        p = dvec2(p.x * p.x - p.y * p.y, 2.0 * p.x * p.y) + c;
+        p = mandelbrotStep(p, c);
 
         if (dot(p,p)>4.0){
-            //The point, c, is not part of the set, so smoothly color it.
-            color = colorScheme(i, max, float(dot(p,p)), 2.0);
+            //The point, c, is not part of the set : keep its iteration for the coloring pass
+            field = vec2(float(i), float(dot(p,p)));
             break;
         }
+
+        if ((features & FEATURE_PERIODICITY) != 0u)
+        {
+            dvec2 d = p - checkpoint;
+            if (dot(d,d) < PERIODICITY_EPSILON_D)
+            {
+                break; // The orbit is periodic, c is in the set
+            }
+            if (++sinceCheckpoint == checkpointInterval)
+            {
+                checkpoint = p;
+                sinceCheckpoint = 0u;
+                checkpointInterval *= 2u;
+            }
+        }
+
+        if ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON)
+        {
+            break; // The orbit converges to a cycle, c is in the set
+        }
     }
 
-    FragColor = color;
+    FragField = field;
 }
@@ -2,38 +2,150 @@
 #pragma optionNV(fastmath off)
 #pragma optionNV(fastprecision off)
 #include <FloatFloat.glsl>
-#include <ColorSchemes.glsl>
+#include <Interior.glsl>
 
-
-in vec2 pos;
-out vec4 FragColor;
+out vec2 FragField; // iteration at escape (max for points in the set) and |z|^2, colored by Color.glsl
 
 uniform vec4 center = vec4(-0.5,0,0,0);
-uniform vec2 scale = vec2(2,0);
-uniform float ratio = 1.0;
+uniform vec4 pixel = vec4(0.005,0,0.005,0); // size of a pixel, x and y as floatfloats
+uniform vec2 offset = vec2(-400,-400); // pixel positions from the center point are gl_FragCoord + offset (see pixelPosition())
 uniform uint max = 1000u;
+uniform uint features = FEATURE_SHAPE_CHECK | FEATURE_PERIODICITY | FEATURE_DERIVATIVE;
+
+// inMainCardioidOrBulb() in floatfloat precision
+bool ff_inMainCardioidOrBulb(vec4 c)
+{
+    vec2 xq = ff_add(c.xy, ff_from_float(-0.25));
+    vec2 y2 = ff_mul(c.zw, c.zw);
+    vec2 q = ff_add(ff_mul(xq, xq), y2);
+    if (ff_cmp(ff_mul(q, ff_add(q, xq)), ff_mul(ff_from_float(0.25), y2)) <= 0)
+    {
+        return true;
+    }
+    vec2 xb = ff_add(c.xy, ff_from_float(1.0));
+    return ff_cmp(ff_add(ff_mul(xb, xb), y2), ff_from_float(0.0625)) <= 0;
+}
+
+// z = z^2 + c
+vec4 mandelbrotStep(vec4 p, vec4 c)
+{
+    return cff_add(cff_mul(p,p),c);
+}
+
+// |z|^2 > 4
+bool escaped(vec4 p)
+{
+    vec2 sqMax = ff_from_float(4.0);
+    return ff_cmp(cff_norm(p) , sqMax ) > 0;
+}
+
+// The difference is tiny when it matters : its high parts are enough
+bool periodic(vec4 p, vec4 checkpoint)
+{
+    vec2 d = vec2(ff_add(p.xy, -checkpoint.xy).x, ff_add(p.zw, -checkpoint.zw).x);
+    return dot(d,d) < PERIODICITY_EPSILON_FF;
+}
 
 void main()
 {
-    vec4 scale2D = vec4( ratio * scale, scale );
-    vec4 pos_cff = cff_from_cf( pos );
-    vec4 scaled_pos = cff_scale( pos_cff, scale2D );
+    vec4 pos_cff = cff_from_cf( gl_FragCoord.xy + offset );
+    vec4 scaled_pos = cff_scale( pos_cff, pixel );
 
     vec4 p = cff_add( scaled_pos , center);
     vec4 c = p;
 
-    vec4 color = vec4(0,0,0,0);
-    for(uint i = 0u; i < max; i++)
+    vec2 field = vec2(float(max), 0.0);
+    if ((features & FEATURE_SHAPE_CHECK) != 0u && ff_inMainCardioidOrBulb(c))
     {
+        FragField = field;
+        return;
+    }
+
+    // Brent's cycle detection : the checkpoint moves to the current point after 1, 2, 4, 8... iterations
+    vec4 checkpoint = p;
+    uint checkpointInterval = 1u;
+    uint sinceCheckpoint = 0u;
+
+    // Derivative detection (see Interior.glsl)
+    vec2 dz = vec2(1.0, 0.0);
+
+    // Blocks of ESCAPE_UNROLL iterations, tested at their end (see Interior.glsl)
+    uint i = 0u;
+    while (i + ESCAPE_UNROLL <= max)
+    {
+        vec4 savedP = p;
+        vec4 savedCheckpoint = checkpoint;
+        uint savedInterval = checkpointInterval;
+        uint savedSince = sinceCheckpoint;
+        vec2 savedDz = dz;
+        bool stop = false;
+        for (uint k = 0u; k < ESCAPE_UNROLL; k++)
+        {
+            if ((features & FEATURE_DERIVATIVE) != 0u)
+            {
+                dz = derive(vec2(p.x, p.z), dz);
+            }
+            p = mandelbrotStep(p, c);
+            stop = stop || escaped(p);
+            if ((features & FEATURE_PERIODICITY) != 0u)
+            {
+                stop = stop || periodic(p, checkpoint);
+                if (++sinceCheckpoint == checkpointInterval)
+                {
+                    checkpoint = p;
+                    sinceCheckpoint = 0u;
+                    checkpointInterval *= 2u;
+                }
+            }
+            stop = stop || ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON);
+        }
+        if (stop)
+        {
+            p = savedP;
+            checkpoint = savedCheckpoint;
+            checkpointInterval = savedInterval;
+            sinceCheckpoint = savedSince;
+            dz = savedDz;
+            break;
+        }
+        i += ESCAPE_UNROLL;
+    }
+
+    // Step by step : the block where the orbit stopped, or the last iterations
+    for(; i < max; i++)
+    {
+        if ((features & FEATURE_DERIVATIVE) != 0u)
+        {
+            dz = derive(vec2(p.x, p.z), dz);
+        }
+
         //Perform complex number arithmetic
-        p = cff_add(cff_mul(p,p),c);
-        vec2 sqMax = ff_from_float(4.0);
-        if ( ff_cmp(cff_norm(p) , sqMax ) > 0 )
+        p = mandelbrotStep(p, c);
+        if (escaped(p))
         {
-            color = colorScheme(i,max, dot(p,p),2.0);
+            field = vec2(float(i), dot(p,p));
             break;
         }
+
+        if ((features & FEATURE_PERIODICITY) != 0u)
+        {
+            if (periodic(p, checkpoint))
+            {
+                break; // The orbit is periodic, c is in the set
+            }
+            if (++sinceCheckpoint == checkpointInterval)
+            {
+                checkpoint = p;
+                sinceCheckpoint = 0u;
+                checkpointInterval *= 2u;
+            }
+        }
+
+        if ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON)
+        {
+            break; // The orbit converges to a cycle, c is in the set
+        }
     }
 
-    FragColor = color;
+    FragField = field;
 }
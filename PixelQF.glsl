@@ -0,0 +1,159 @@
+#version 420 core
+#pragma optionNV(fastmath off)
+#pragma optionNV(fastprecision off)
+#include <QuadFloat.glsl>
+#include <Interior.glsl>
+
+out vec2 FragField; // iteration at escape (max for points in the set) and |z|^2, colored by Color.glsl
+
+uniform vec4 center[2] = vec4[2](vec4(-0.5,0,0,0), vec4(0,0,0,0)); // x and y as quadfloats
+uniform vec4 scale = vec4(2,0,0,0);
+uniform vec4 pixel[2] = vec4[2](vec4(0.005,0,0,0), vec4(0.005,0,0,0)); // size of a pixel, x and y as quadfloats
+uniform vec2 offset = vec2(-400,-400); // pixel positions from the center point are gl_FragCoord + offset (see pixelPosition())
+uniform uint max = 1000u;
+uniform uint features = FEATURE_SHAPE_CHECK | FEATURE_PERIODICITY | FEATURE_DERIVATIVE;
+
+// inMainCardioidOrBulb() in quadfloat precision
+bool qf_inMainCardioidOrBulb(vec4 x, vec4 y)
+{
+    vec4 xq = qf_add(x, qf_from_float(-0.25));
+    vec4 y2 = qf_mul(y, y);
+    vec4 q = qf_add(qf_mul(xq, xq), y2);
+    if (qf_cmp(qf_mul(q, qf_add(q, xq)), qf_mul(qf_from_float(0.25), y2)) <= 0)
+    {
+        return true;
+    }
+    vec4 xb = qf_add(x, qf_from_float(1.0));
+    return qf_cmp(qf_add(qf_mul(xb, xb), y2), qf_from_float(0.0625)) <= 0;
+}
+
+void main()
+{
+    vec2 pos = gl_FragCoord.xy + offset;
+    vec4 cx = qf_add(qf_mul(qf_from_float(pos.x), pixel[0]), center[0]);
+    vec4 cy = qf_add(qf_mul(qf_from_float(pos.y), pixel[1]), center[1]);
+
+    vec2 field = vec2(float(max), 0.0);
+    if ((features & FEATURE_SHAPE_CHECK) != 0u && qf_inMainCardioidOrBulb(cx, cy))
+    {
+        FragField = field;
+        return;
+    }
+
+    // Brent's cycle detection, on the distance relative to the scale (its square is below the float range)
+    vec4 checkX = cx;
+    vec4 checkY = cy;
+    uint checkpointInterval = 1u;
+    uint sinceCheckpoint = 0u;
+
+    // Derivative detection (see Interior.glsl)
+    vec2 dz = vec2(1.0, 0.0);
+
+    vec4 x = cx;
+    vec4 y = cy;
+    vec4 x2 = qf_mul(x, x);
+    vec4 y2 = qf_mul(y, y);
+
+    // Blocks of ESCAPE_UNROLL iterations, tested at their end (see Interior.glsl)
+    uint i = 0u;
+    while (i + ESCAPE_UNROLL <= max)
+    {
+        vec4 savedX = x;
+        vec4 savedY = y;
+        vec4 savedX2 = x2;
+        vec4 savedY2 = y2;
+        vec4 savedCheckX = checkX;
+        vec4 savedCheckY = checkY;
+        uint savedInterval = checkpointInterval;
+        uint savedSince = sinceCheckpoint;
+        vec2 savedDz = dz;
+        bool stop = false;
+        for (uint k = 0u; k < ESCAPE_UNROLL; k++)
+        {
+            if ((features & FEATURE_DERIVATIVE) != 0u)
+            {
+                dz = derive(vec2(x.x, y.x), dz);
+            }
+            vec4 xy = qf_mul(x, y);
+            x = qf_add(qf_add(x2, -y2), cx);
+            y = qf_add(2.0 * xy, cy);
+            x2 = qf_mul(x, x);
+            y2 = qf_mul(y, y);
+            stop = stop || x2.x + y2.x > 4.0;
+            if ((features & FEATURE_PERIODICITY) != 0u)
+            {
+                vec2 d = vec2(qf_add(x, -checkX).x, qf_add(y, -checkY).x) / scale.x;
+                stop = stop || dot(d, d) < PERIODICITY_EPSILON_QF;
+                if (++sinceCheckpoint == checkpointInterval)
+                {
+                    checkX = x;
+                    checkY = y;
+                    sinceCheckpoint = 0u;
+                    checkpointInterval *= 2u;
+                }
+            }
+            stop = stop || ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON);
+        }
+        if (stop)
+        {
+            x = savedX;
+            y = savedY;
+            x2 = savedX2;
+            y2 = savedY2;
+            checkX = savedCheckX;
+            checkY = savedCheckY;
+            checkpointInterval = savedInterval;
+            sinceCheckpoint = savedSince;
+            dz = savedDz;
+            break;
+        }
+        i += ESCAPE_UNROLL;
+    }
+
+    // Step by step : the block where the orbit stopped, or the last iterations
+    for(; i < max; i++)
+    {
+        if ((features & FEATURE_DERIVATIVE) != 0u)
+        {
+            dz = derive(vec2(x.x, y.x), dz);
+        }
+
+        //Perform complex number arithmetic
+        vec4 xy = qf_mul(x, y);
+        x = qf_add(qf_add(x2, -y2), cx);
+        y = qf_add(2.0 * xy, cy);
+        x2 = qf_mul(x, x);
+        y2 = qf_mul(y, y);
+
+        // The high parts are enough to compare the norm to 4
+        float norm = x2.x + y2.x;
+        if (norm > 4.0)
+        {
+            field = vec2(float(i), norm);
+            break;
+        }
+
+        if ((features & FEATURE_PERIODICITY) != 0u)
+        {
+            vec2 d = vec2(qf_add(x, -checkX).x, qf_add(y, -checkY).x) / scale.x;
+            if (dot(d, d) < PERIODICITY_EPSILON_QF)
+            {
+                break; // The orbit is periodic, c is in the set
+            }
+            if (++sinceCheckpoint == checkpointInterval)
+            {
+                checkX = x;
+                checkY = y;
+                sinceCheckpoint = 0u;
+                checkpointInterval *= 2u;
+            }
+        }
+
+        if ((features & FEATURE_DERIVATIVE) != 0u && dot(dz,dz) < DERIVATIVE_EPSILON)
+        {
+            break; // The orbit converges to a cycle, c is in the set
+        }
+    }
+
+    FragField = field;
+}
@@ -0,0 +1,270 @@
+#ifndef PRECISION_HPP_
+#define PRECISION_HPP_
+
+// Number types of the escape-time kernels. escapeTime<T>() (EscapeKernels.hpp) is written once
+// for any precision : Precision<T> tells it how to compute with T. Each specialization provides
+//   Precision(const View &view, ...)        the per-frame constants (center, scale) in T
+//   void pixel(posX, posY, cx, cy) const    c for a pixel at pixelPosition() (posX, posY), as computed by the shader
+//   static T constant(float)                exact conversion
+//   static T add(a, b), sub(a, b), mul(a, b), sqr(a)
+//   static T twiceProduct(x, y)             2xy, in the operation order of the shader
+//   static bool lessEqual(a, b)
+//   static bool escaped(x, y, x2, y2, norm) |z|^2 > 4 given the squares, and the norm passed to the coloring pass
+//   Real difference(a, b) const             a - b rounded to Real, for the periodicity test
+//   static Real periodicityEpsilon()        squared distance of the periodicity test (Interior.glsl)
+//   static Real real(a)                     a rounded to Real, for the derivative
+// Each operation is the fastest one the type has (e.g. a dedicated square), as long as the
+// results stay identical to the shader's.
+
+#include <CoreMacros.hpp>
+
+#include "View.hpp"
+#include "FloatFloat.hpp"
+#include "DoubleDouble.hpp"
+#include "QuadFloat.hpp"
+
+// Periodicity detection : squared distance under which the orbit is considered back
+// to its checkpoint, for each precision (Interior.glsl)
+const float PERIODICITY_EPSILON_F = 1e-12f;
+const float PERIODICITY_EPSILON_FF = 1e-26f;
+const double PERIODICITY_EPSILON_D = 1e-28;
+const double PERIODICITY_EPSILON_DD = 1e-60;
+const float PERIODICITY_EPSILON_QF = 1e-20f; // relative to the scale (squared)
+
+// Derivative detection : squared norm of dz_n/dz_1 under which the orbit is attracted by a cycle
+// (Interior.glsl). The same float constant for all precisions, as in the shaders.
+const float DERIVATIVE_EPSILON = 1e-12f;
+
+template <typename T>
+class Precision;
+
+/// Hardware float or double (PixelF.glsl, PixelD.glsl)
+template <typename T>
+class HardwarePrecision
+{
+  public:
+    typedef T Real;
+
+    static T constant(float x) { return T(x); }
+    static T add(T a, T b) { return a + b; }
+    static T sub(T a, T b) { return a - b; }
+    static T mul(T a, T b) { return a * b; }
+    static T sqr(T a) { return a * a; }
+    static T twiceProduct(T x, T y) { return T(2) * x * y; }
+    static bool lessEqual(T a, T b) { return a <= b; }
+
+    static bool escaped(T, T, T x2, T y2, float &norm)
+    {
+        const T n = x2 + y2;
+        norm = static_cast<float>(n);
+        return n > T(4);
+    }
+
+    T difference(T a, T b) const { return a - b; }
+    static T real(T a) { return a; }
+};
+
+/// PixelF.glsl
+template <>
+class Precision<float> : public HardwarePrecision<float>
+{
+  public:
+    explicit Precision(const View &view)
+        : m_pixelX(static_cast<float>(pixelWidth(view, view.scale))),
+          m_pixelY(static_cast<float>(pixelHeight(view, view.scale))),
+          m_centerX(static_cast<float>(view.centerX)),
+          m_centerY(static_cast<float>(view.centerY))
+    {
+    }
+
+    void pixel(float posX, float posY, float &cx, float &cy) const
+    {
+        cx = posX * m_pixelX + m_centerX;
+        cy = posY * m_pixelY + m_centerY;
+    }
+
+    static float periodicityEpsilon() { return PERIODICITY_EPSILON_F; }
+
+  private:
+    float m_pixelX, m_pixelY;
+    float m_centerX, m_centerY;
+};
+
+/// PixelD.glsl
+template <>
+class Precision<double> : public HardwarePrecision<double>
+{
+  public:
+    explicit Precision(const View &view)
+        : m_pixelX(pixelWidth(view, view.scale)),
+          m_pixelY(pixelHeight(view, view.scale)),
+          m_centerX(view.centerX),
+          m_centerY(view.centerY)
+    {
+    }
+
+    void pixel(float posX, float posY, double &cx, double &cy) const
+    {
+        cx = static_cast<double>(posX) * m_pixelX + m_centerX;
+        cy = static_cast<double>(posY) * m_pixelY + m_centerY;
+    }
+
+    static double periodicityEpsilon() { return PERIODICITY_EPSILON_D; }
+
+  private:
+    double m_pixelX, m_pixelY;
+    double m_centerX, m_centerY;
+};
+
+/// PixelFF.glsl. The shader squares z with a complex product : 2xy is the sum of xy and yx.
+template <>
+class Precision<FloatFloat>
+{
+  public:
+    typedef float Real;
+
+    explicit Precision(const View &view)
+        : m_center{FloatFloat(view.centerX), FloatFloat(view.centerY)},
+          m_pixel{FloatFloat(pixelWidth(view, view.scale)), FloatFloat(pixelHeight(view, view.scale))}
+    {
+    }
+
+    void pixel(float posX, float posY, FloatFloat &cx, FloatFloat &cy) const
+    {
+        const ComplexFF c = cff_add(cff_scale(cff_from_cf(posX, posY), m_pixel), m_center);
+        cx = c.re;
+        cy = c.im;
+    }
+
+    static FloatFloat constant(float x) { return FloatFloat(x, 0.f); }
+    static FloatFloat add(FloatFloat a, FloatFloat b) { return ff_add(a, b); }
+    static FloatFloat sub(FloatFloat a, FloatFloat b) { return ff_add(a, ff_neg(b)); }
+    static FloatFloat mul(FloatFloat a, FloatFloat b) { return ff_mul(a, b); }
+    static FloatFloat sqr(FloatFloat a) { return ff_mul(a, a); }
+    static FloatFloat twiceProduct(FloatFloat x, FloatFloat y) { return ff_add(ff_mul(x, y), ff_mul(y, x)); }
+    static bool lessEqual(FloatFloat a, FloatFloat b) { return ff_cmp(a, b) <= 0; }
+
+    static bool escaped(FloatFloat x, FloatFloat y, FloatFloat x2, FloatFloat y2, float &norm)
+    {
+        if (ff_cmp(ff_add(x2, y2), FloatFloat(4.0f, 0.f)) <= 0)
+        {
+            return false;
+        }
+        // dot(p,p) on the vec4 representation
+        norm = x.high * x.high + x.low * x.low + y.high * y.high + y.low * y.low;
+        return true;
+    }
+
+    /// The difference is tiny when it matters : its high part is enough
+    float difference(FloatFloat a, FloatFloat b) const { return ff_add(a, ff_neg(b)).high; }
+    static float real(FloatFloat a) { return a.high; }
+
+    static float periodicityEpsilon() { return PERIODICITY_EPSILON_FF; }
+
+  private:
+    ComplexFF m_center;
+    ComplexFF m_pixel;
+};
+
+/// Doubledouble precision (CPU only), with a dedicated square
+template <>
+class Precision<DoubleDouble>
+{
+  public:
+    typedef double Real;
+
+    /// The center is given separately, since a double can't hold it
+    Precision(const View &view, const ComplexDD &center)
+        : m_pixelX(pixelWidth(view, view.scale)),
+          m_pixelY(pixelHeight(view, view.scale)),
+          m_center(center)
+    {
+    }
+
+    /// The offset from the center only needs double precision
+    void pixel(float posX, float posY, DoubleDouble &cx, DoubleDouble &cy) const
+    {
+        cx = dd_add(m_center.re, DoubleDouble(static_cast<double>(posX) * m_pixelX));
+        cy = dd_add(m_center.im, DoubleDouble(static_cast<double>(posY) * m_pixelY));
+    }
+
+    static DoubleDouble constant(float x) { return DoubleDouble(static_cast<double>(x)); }
+    static DoubleDouble add(DoubleDouble a, DoubleDouble b) { return dd_add(a, b); }
+    static DoubleDouble sub(DoubleDouble a, DoubleDouble b) { return dd_sub(a, b); }
+    static DoubleDouble mul(DoubleDouble a, DoubleDouble b) { return dd_mul(a, b); }
+    static DoubleDouble sqr(DoubleDouble a) { return dd_sqr(a); }
+    static DoubleDouble twiceProduct(DoubleDouble x, DoubleDouble y) { return dd_mul2(dd_mul(x, y)); }
+    static bool lessEqual(DoubleDouble a, DoubleDouble b) { return dd_cmp(a, b) <= 0; }
+
+    static bool escaped(DoubleDouble, DoubleDouble, DoubleDouble x2, DoubleDouble y2, float &norm)
+    {
+        const double n = dd_add(x2, y2).high;
+        norm = static_cast<float>(n);
+        return n > 4.0;
+    }
+
+    /// The difference is tiny when it matters : its high part is enough
+    double difference(DoubleDouble a, DoubleDouble b) const { return dd_sub(a, b).high; }
+    static double real(DoubleDouble a) { return a.high; }
+
+    static double periodicityEpsilon() { return PERIODICITY_EPSILON_DD; }
+
+  private:
+    double m_pixelX, m_pixelY;
+    ComplexDD m_center;
+};
+
+/// PixelQF.glsl. The periodicity test is relative to the scale : the squared distances
+/// would fall below the float range.
+template <>
+class Precision<QuadFloat>
+{
+  public:
+    typedef float Real;
+
+    /// The center is given separately, as the uniforms : a double can't hold it
+    Precision(const View &view, const QuadFloat *center)
+        : m_scale(view.scale),
+          m_pixelX(pixelWidth(view, view.scale)),
+          m_pixelY(pixelHeight(view, view.scale)),
+          m_centerX(center[0]),
+          m_centerY(center[1])
+    {
+    }
+
+    void pixel(float posX, float posY, QuadFloat &cx, QuadFloat &cy) const
+    {
+        cx = qf_add(qf_mul(qf_from_float(posX), m_pixelX), m_centerX);
+        cy = qf_add(qf_mul(qf_from_float(posY), m_pixelY), m_centerY);
+    }
+
+    static QuadFloat constant(float x) { return qf_from_float(x); }
+    static QuadFloat add(const QuadFloat &a, const QuadFloat &b) { return qf_add(a, b); }
+    static QuadFloat sub(const QuadFloat &a, const QuadFloat &b) { return qf_add(a, qf_neg(b)); }
+    static QuadFloat mul(const QuadFloat &a, const QuadFloat &b) { return qf_mul(a, b); }
+    static QuadFloat sqr(const QuadFloat &a) { return qf_mul(a, a); }
+    static QuadFloat twiceProduct(const QuadFloat &x, const QuadFloat &y) { return qf_mul2(qf_mul(x, y)); }
+    static bool lessEqual(const QuadFloat &a, const QuadFloat &b) { return qf_cmp(a, b) <= 0; }
+
+    /// The high parts are enough to compare the norm to 4
+    static bool escaped(const QuadFloat &, const QuadFloat &, const QuadFloat &x2, const QuadFloat &y2, float &norm)
+    {
+        norm = x2.values[0] + y2.values[0];
+        return norm > 4.0f;
+    }
+
+    float difference(const QuadFloat &a, const QuadFloat &b) const
+    {
+        return qf_add(a, qf_neg(b)).values[0] / m_scale.values[0];
+    }
+    static float real(const QuadFloat &a) { return a.values[0]; }
+
+    static float periodicityEpsilon() { return PERIODICITY_EPSILON_QF; }
+
+  private:
+    QuadFloat m_scale;
+    QuadFloat m_pixelX, m_pixelY;
+    QuadFloat m_centerX, m_centerY;
+};
+
+#endif // PRECISION_HPP_
@@ -0,0 +1,193 @@
+// Operations for quadruple precision emulation with four floats (aka quadfloat)
+// .x = most significant part, then .y, .z, .w
+// Algorithms of Hida, Li and Bailey's quad-double library, applied to floats. Mirrors QuadFloat.hpp.
+
+// create a quadfloat from a single float value
+vec4 qf_from_float(float a)
+{
+    return vec4(a, 0.0, 0.0, 0.0);
+}
+
+// a + b = s + e
+float qf_two_sum(float a, float b, out float e)
+{
+    precise float s = a + b;
+    precise float bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+// a + b = s + e, if |a| >= |b|
+float qf_quick_two_sum(float a, float b, out float e)
+{
+    precise float s = a + b;
+    e = b - (s - a);
+    return s;
+}
+
+// a * b = p + e, by splitting the 24-bit mantissas in 12-bit halves
+float qf_two_prod(float a, float b, out float e)
+{
+    const float split = 4097.0; // = 2^12 + 1
+    precise float p = a * b;
+    precise float ca = split * a;
+    precise float ahi = ca - (ca - a);
+    precise float alo = a - ahi;
+    precise float cb = split * b;
+    precise float bhi = cb - (cb - b);
+    precise float blo = b - bhi;
+    e = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+    return p;
+}
+
+// (a, b, c) = a + b + c, with a the most significant
+void qf_three_sum(inout float a, inout float b, inout float c)
+{
+    precise float t2, t3;
+    precise float t1 = qf_two_sum(a, b, t2);
+    a = qf_two_sum(c, t1, t3);
+    b = qf_two_sum(t2, t3, c);
+}
+
+// (a, b) = a + b + c, rounding the last part
+void qf_three_sum2(inout float a, inout float b, float c)
+{
+    precise float t2, t3;
+    precise float t1 = qf_two_sum(a, b, t2);
+    a = qf_two_sum(c, t1, t3);
+    b = t2 + t3;
+}
+
+// Renormalize five overlapping parts to a quadfloat
+vec4 qf_renorm(float c0, float c1, float c2, float c3, float c4)
+{
+    precise float s0, s1;
+    precise float s2 = 0.0;
+    precise float s3 = 0.0;
+    s0 = qf_quick_two_sum(c3, c4, c4);
+    s0 = qf_quick_two_sum(c2, s0, c3);
+    s0 = qf_quick_two_sum(c1, s0, c2);
+    c0 = qf_quick_two_sum(c0, s0, c1);
+
+    s0 = c0;
+    s1 = c1;
+    if (s1 != 0.0)
+    {
+        s1 = qf_quick_two_sum(s1, c2, s2);
+        if (s2 != 0.0)
+        {
+            s2 = qf_quick_two_sum(s2, c3, s3);
+            if (s3 != 0.0)
+            {
+                s3 += c4;
+            }
+            else
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+        }
+        else
+        {
+            s1 = qf_quick_two_sum(s1, c3, s2);
+            if (s2 != 0.0)
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+            else
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+        }
+    }
+    else
+    {
+        s0 = qf_quick_two_sum(s0, c2, s1);
+        if (s1 != 0.0)
+        {
+            s1 = qf_quick_two_sum(s1, c3, s2);
+            if (s2 != 0.0)
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+            else
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+        }
+        else
+        {
+            s0 = qf_quick_two_sum(s0, c3, s1);
+            if (s1 != 0.0)
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+            else
+            {
+                s0 = qf_quick_two_sum(s0, c4, s1);
+            }
+        }
+    }
+    return vec4(s0, s1, s2, s3);
+}
+
+// Addition of 2 quadfloats
+vec4 qf_add(vec4 a, vec4 b)
+{
+    precise float t0, t1, t2, t3;
+    precise float s0 = qf_two_sum(a.x, b.x, t0);
+    precise float s1 = qf_two_sum(a.y, b.y, t1);
+    precise float s2 = qf_two_sum(a.z, b.z, t2);
+    precise float s3 = qf_two_sum(a.w, b.w, t3);
+
+    s1 = qf_two_sum(s1, t0, t0);
+    qf_three_sum(s2, t0, t1);
+    qf_three_sum2(s3, t0, t2);
+    t0 = t0 + t1 + t3;
+    return qf_renorm(s0, s1, s2, s3, t0);
+}
+
+// Multiplication of 2 quadfloats
+vec4 qf_mul(vec4 a, vec4 b)
+{
+    // Products of order 1, eps and eps^2, with their errors
+    precise float q0, q1, q2, q3, q4, q5;
+    precise float p0 = qf_two_prod(a.x, b.x, q0);
+    precise float p1 = qf_two_prod(a.x, b.y, q1);
+    precise float p2 = qf_two_prod(a.y, b.x, q2);
+    precise float p3 = qf_two_prod(a.x, b.z, q3);
+    precise float p4 = qf_two_prod(a.y, b.y, q4);
+    precise float p5 = qf_two_prod(a.z, b.x, q5);
+
+    // Order eps
+    qf_three_sum(p1, p2, q0);
+
+    // Order eps^2 : (p2, q1, q2) + (p3, p4, p5)
+    qf_three_sum(p2, q1, q2);
+    qf_three_sum(p3, p4, p5);
+    precise float t0, t1;
+    precise float s0 = qf_two_sum(p2, p3, t0);
+    precise float s1 = qf_two_sum(q1, p4, t1);
+    precise float s2 = q2 + p5;
+    s1 = qf_two_sum(s1, t0, t0);
+    s2 += (t0 + t1);
+
+    // Order eps^3
+    s1 += a.x * b.w + a.y * b.z + a.z * b.y + a.w * b.x + q0 + q3 + q4 + q5;
+    return qf_renorm(p0, p1, s0, s1, s2);
+}
+
+// compare two quadfloats
+// -1 if a < b
+// 0 if a == b
+// 1 if a > b
+float qf_cmp(vec4 a, vec4 b)
+{
+    for (int k = 0; k < 4; ++k)
+    {
+        if (a[k] != b[k])
+        {
+            return a[k] < b[k] ? -1. : 1.;
+        }
+    }
+    return 0.;
+}
@@ -0,0 +1,244 @@
+#ifndef QUADFLOAT_HPP_
+#define QUADFLOAT_HPP_
+
+#include "BigFixed.hpp"
+
+/// Quadruple precision emulation : represent a number with four non-overlapping `float`s
+/// (about 96 bits of mantissa), for GPUs without double precision. Aka QuadFloat.
+/// Algorithms of Hida, Li and Bailey's quad-double library, applied to floats.
+/// Mirrors QuadFloat.glsl operation for operation.
+struct QuadFloat
+{
+    float values[4]; // most significant first
+
+    QuadFloat() {} /// Create an uninitialized QuadFloat
+    QuadFloat(float a, float b, float c, float d) : values{a, b, c, d} {} /// Create a QuadFloat from four values
+
+    /// Create a QuadFloat from a double (exact)
+    QuadFloat(double x)
+    {
+        for (uint k = 0; k < 4; ++k)
+        {
+            values[k] = static_cast<float>(x);
+            x -= static_cast<double>(values[k]);
+        }
+    }
+
+    /// Create a QuadFloat from an arbitrary precision number (rounded to 96 bits)
+    explicit QuadFloat(const BigFixed &x)
+    {
+        BigFixed r = x;
+        for (uint k = 0; k < 4; ++k)
+        {
+            values[k] = static_cast<float>(r.toDouble());
+            r -= BigFixed(static_cast<double>(values[k]));
+        }
+    }
+
+    /// convert the value back to a double
+    double toDouble() const
+    {
+        return static_cast<double>(values[0]) + static_cast<double>(values[1]) + static_cast<double>(values[2]) +
+               static_cast<double>(values[3]);
+    }
+};
+
+// Error-free transformations : the rounding error of an operation is returned in `e`
+
+/// a + b = s + e
+inline float qf_two_sum(float a, float b, float &e)
+{
+    const float s = a + b;
+    const float bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+/// a + b = s + e, if |a| >= |b|
+inline float qf_quick_two_sum(float a, float b, float &e)
+{
+    const float s = a + b;
+    e = b - (s - a);
+    return s;
+}
+
+/// a * b = p + e, by Dekker's splitting of the 24-bit mantissas in 12-bit halves
+inline float qf_two_prod(float a, float b, float &e)
+{
+    const float split = 4097.0f; // = 2^12 + 1
+    const float p = a * b;
+    const float ca = split * a;
+    const float ahi = ca - (ca - a);
+    const float alo = a - ahi;
+    const float cb = split * b;
+    const float bhi = cb - (cb - b);
+    const float blo = b - bhi;
+    e = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+    return p;
+}
+
+/// (a, b, c) = a + b + c, with a the most significant
+inline void qf_three_sum(float &a, float &b, float &c)
+{
+    float t2, t3;
+    const float t1 = qf_two_sum(a, b, t2);
+    a = qf_two_sum(c, t1, t3);
+    b = qf_two_sum(t2, t3, c);
+}
+
+/// (a, b) = a + b + c, rounding the last part
+inline void qf_three_sum2(float &a, float &b, float c)
+{
+    float t2, t3;
+    const float t1 = qf_two_sum(a, b, t2);
+    a = qf_two_sum(c, t1, t3);
+    b = t2 + t3;
+}
+
+/// Renormalize five overlapping parts to a QuadFloat
+inline QuadFloat qf_renorm(float c0, float c1, float c2, float c3, float c4)
+{
+    float s0, s1, s2 = 0.f, s3 = 0.f;
+    s0 = qf_quick_two_sum(c3, c4, c4);
+    s0 = qf_quick_two_sum(c2, s0, c3);
+    s0 = qf_quick_two_sum(c1, s0, c2);
+    c0 = qf_quick_two_sum(c0, s0, c1);
+
+    s0 = c0;
+    s1 = c1;
+    if (s1 != 0.f)
+    {
+        s1 = qf_quick_two_sum(s1, c2, s2);
+        if (s2 != 0.f)
+        {
+            s2 = qf_quick_two_sum(s2, c3, s3);
+            if (s3 != 0.f)
+            {
+                s3 += c4;
+            }
+            else
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+        }
+        else
+        {
+            s1 = qf_quick_two_sum(s1, c3, s2);
+            if (s2 != 0.f)
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+            else
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+        }
+    }
+    else
+    {
+        s0 = qf_quick_two_sum(s0, c2, s1);
+        if (s1 != 0.f)
+        {
+            s1 = qf_quick_two_sum(s1, c3, s2);
+            if (s2 != 0.f)
+            {
+                s2 = qf_quick_two_sum(s2, c4, s3);
+            }
+            else
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+        }
+        else
+        {
+            s0 = qf_quick_two_sum(s0, c3, s1);
+            if (s1 != 0.f)
+            {
+                s1 = qf_quick_two_sum(s1, c4, s2);
+            }
+            else
+            {
+                s0 = qf_quick_two_sum(s0, c4, s1);
+            }
+        }
+    }
+    return QuadFloat(s0, s1, s2, s3);
+}
+
+inline QuadFloat qf_from_float(float a)
+{
+    return QuadFloat(a, 0.f, 0.f, 0.f);
+}
+
+inline QuadFloat qf_neg(const QuadFloat &a)
+{
+    return QuadFloat(-a.values[0], -a.values[1], -a.values[2], -a.values[3]);
+}
+
+/// 2 a, exact
+inline QuadFloat qf_mul2(const QuadFloat &a)
+{
+    return QuadFloat(2.f * a.values[0], 2.f * a.values[1], 2.f * a.values[2], 2.f * a.values[3]);
+}
+
+inline QuadFloat qf_add(const QuadFloat &a, const QuadFloat &b)
+{
+    float t0, t1, t2, t3;
+    const float s0 = qf_two_sum(a.values[0], b.values[0], t0);
+    float s1 = qf_two_sum(a.values[1], b.values[1], t1);
+    float s2 = qf_two_sum(a.values[2], b.values[2], t2);
+    float s3 = qf_two_sum(a.values[3], b.values[3], t3);
+
+    s1 = qf_two_sum(s1, t0, t0);
+    qf_three_sum(s2, t0, t1);
+    qf_three_sum2(s3, t0, t2);
+    t0 = t0 + t1 + t3;
+    return qf_renorm(s0, s1, s2, s3, t0);
+}
+
+inline QuadFloat qf_mul(const QuadFloat &a, const QuadFloat &b)
+{
+    const float *x = a.values;
+    const float *y = b.values;
+
+    // Products of order 1, eps and eps^2, with their errors
+    float q0, q1, q2, q3, q4, q5;
+    const float p0 = qf_two_prod(x[0], y[0], q0);
+    float p1 = qf_two_prod(x[0], y[1], q1);
+    float p2 = qf_two_prod(x[1], y[0], q2);
+    float p3 = qf_two_prod(x[0], y[2], q3);
+    float p4 = qf_two_prod(x[1], y[1], q4);
+    float p5 = qf_two_prod(x[2], y[0], q5);
+
+    // Order eps
+    qf_three_sum(p1, p2, q0);
+
+    // Order eps^2 : (p2, q1, q2) + (p3, p4, p5)
+    qf_three_sum(p2, q1, q2);
+    qf_three_sum(p3, p4, p5);
+    float t0, t1;
+    const float s0 = qf_two_sum(p2, p3, t0);
+    float s1 = qf_two_sum(q1, p4, t1);
+    float s2 = q2 + p5;
+    s1 = qf_two_sum(s1, t0, t0);
+    s2 += (t0 + t1);
+
+    // Order eps^3
+    s1 += x[0] * y[3] + x[1] * y[2] + x[2] * y[1] + x[3] * y[0] + q0 + q3 + q4 + q5;
+    return qf_renorm(p0, p1, s0, s1, s2);
+}
+
+/// -1 if a < b, 0 if a == b, 1 if a > b
+inline int qf_cmp(const QuadFloat &a, const QuadFloat &b)
+{
+    for (uint k = 0; k < 4; ++k)
+    {
+        if (a.values[k] != b.values[k])
+        {
+            return a.values[k] < b.values[k] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+#endif // QUADFLOAT_HPP_
@@ -0,0 +1,19 @@
+#version 420 core
+
+// Zoom preview : the previous iteration field, scaled around the center of the view, written to
+// the new field until its pixels are computed again. Each pixel takes the nearest sample, as
+// reprojectZoom() (IterationField.hpp) expects.
+
+in vec2 pos;
+out vec2 FragField;
+
+uniform sampler2D previous; // iteration field of the previous view
+uniform float zoom = 1.0;   // new scale / previous scale
+
+void main()
+{
+    ivec2 size = textureSize(previous, 0);
+    vec2 source = (pos * zoom + 1.0) * 0.5 * vec2(size) - 0.5;
+    ivec2 nearest = clamp(ivec2(round(source)), ivec2(0), size - 1);
+    FragField = texelFetch(previous, nearest, 0).xy;
+}
@@ -0,0 +1,111 @@
+#include "SimdKernels.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+SimdIsa detectSimdIsa()
+{
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return SIMD_SCALAR;
+    }
+
+    // Check that the OS saves the AVX (and AVX-512) registers
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave)
+    {
+        return SIMD_SCALAR;
+    }
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0 && fma && (xcr0 & 0x6) == 0x6;
+    const bool avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+    return avx512 ? SIMD_AVX512 : (avx2 ? SIMD_AVX2 : SIMD_SCALAR);
+#elif defined(SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return SIMD_AVX2;
+    }
+    return SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+const char *simdIsaName(SimdIsa isa)
+{
+    switch (isa)
+    {
+    case SIMD_SCALAR:
+        return "scalar";
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_AVX512:
+        return "avx512";
+    default:
+        CORE_ASSERT(false, "should not get here");
+    }
+    return "";
+}
+
+void escapeDoubleRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    switch (isa)
+    {
+    case SIMD_AVX512:
+        escapeDoubleRowAVX512(posX, posY, count, view, results);
+        break;
+    case SIMD_AVX2:
+        escapeDoubleRowAVX2(posX, posY, count, view, results);
+        break;
+    default:
+        for (uint i = 0; i < count; ++i)
+        {
+            results[i] = escapeDouble(posX[i], posY, view);
+        }
+    }
+}
+
+void escapeFloatFloatRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    switch (isa)
+    {
+    case SIMD_AVX512:
+        escapeFloatFloatRowAVX512(posX, posY, count, view, results);
+        break;
+    case SIMD_AVX2:
+        escapeFloatFloatRowAVX2(posX, posY, count, view, results);
+        break;
+    default:
+        for (uint i = 0; i < count; ++i)
+        {
+            results[i] = escapeFloatFloat(posX[i], posY, view);
+        }
+    }
+}
+
+void escapeDoubleDoubleRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view,
+                           const ComplexDD &center, EscapeResult *results)
+{
+    // Same results either way : std::fma is exact, in hardware or not
+    if (isa >= SIMD_AVX2)
+    {
+        escapeDoubleDoubleRowFMA(posX, posY, count, view, center, results);
+        return;
+    }
+    for (uint i = 0; i < count; ++i)
+    {
+        results[i] = escapeDoubleDouble(posX[i], posY, view, center);
+    }
+}
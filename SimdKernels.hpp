@@ -0,0 +1,65 @@
+#ifndef SIMDKERNELS_HPP_
+#define SIMDKERNELS_HPP_
+
+// Vectorized versions of escapeDouble(), iterating several pixels of a row at once.
+// Each lane keeps its own escape mask and iteration counter. The kernels never use FMA
+// and perform the same operations as escapeDouble(), so iteration counts are bit-identical.
+// The floatfloat kernel is dispatched here too : escapeFloatFloatBatch() is compiled once per
+// instruction set, with batches as wide as the vector registers.
+// The doubledouble kernel is also dispatched here : it needs hardware FMA (which comes with AVX2)
+// to be fast.
+
+#include <CoreMacros.hpp>
+
+#include "View.hpp"
+#include "EscapeKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86
+#endif
+
+// Compiles a single function for an instruction set, with everything it calls inlined into it.
+// Whole files are never compiled with -mavx2 and the like : the inline functions and templates
+// they instantiate (kernels, standard library) would be shared with the other files at link time,
+// and the copy with the wider instructions could be the one kept. See CheckIsaObjects.cmake.
+// MSVC needs no flag for the intrinsics.
+#if defined(SIMD_X86) && defined(__GNUC__)
+#define SIMD_TARGET(isa) __attribute__((target(isa), flatten))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+/// Instruction sets available for the double precision kernel
+enum SimdIsa
+{
+    SIMD_SCALAR = 0, // escapeDouble(), one pixel at a time
+    SIMD_AVX2,       // 4 doubles per instruction
+    SIMD_AVX512,     // 8 doubles per instruction
+};
+
+/// Widest instruction set supported by both the build and the running CPU
+SimdIsa detectSimdIsa();
+
+/// Name of an instruction set, for logs
+const char *simdIsaName(SimdIsa isa);
+
+/// Run PixelD.glsl on `count` pixels of a row, with the given horizontal positions
+/// and common vertical position. Results are written to `results[0..count-1]`.
+void escapeDoubleRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+
+/// Run PixelFF.glsl on `count` pixels of a row
+void escapeFloatFloatRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+
+/// Run escapeDoubleDouble() on `count` pixels of a row
+void escapeDoubleDoubleRow(SimdIsa isa, const float *posX, float posY, uint count, const View &view,
+                           const ComplexDD &center, EscapeResult *results);
+
+// Implementations, each compiled in its own file with the matching instruction set enabled
+void escapeDoubleRowAVX2(const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+void escapeDoubleRowAVX512(const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+void escapeFloatFloatRowAVX2(const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+void escapeFloatFloatRowAVX512(const float *posX, float posY, uint count, const View &view, EscapeResult *results);
+void escapeDoubleDoubleRowFMA(const float *posX, float posY, uint count, const View &view, const ComplexDD &center,
+                              EscapeResult *results);
+
+#endif // SIMDKERNELS_HPP_
@@ -0,0 +1,186 @@
+// Functions compiled with AVX2 and FMA enabled (SIMD_TARGET). Only called when the CPU supports them.
+#include "SimdKernels.hpp"
+
+#ifdef SIMD_X86
+
+#include <immintrin.h>
+#include <algorithm>
+
+namespace
+{
+// Vector version of inMainCardioidOrBulb(), returns a lane mask
+SIMD_TARGET("avx2,fma")
+__m256d insideCardioidOrBulb(__m256d x, __m256d y)
+{
+    const __m256d xq = _mm256_sub_pd(x, _mm256_set1_pd(0.25));
+    const __m256d y2 = _mm256_mul_pd(y, y);
+    const __m256d q = _mm256_add_pd(_mm256_mul_pd(xq, xq), y2);
+    const __m256d cardioid = _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, xq)),
+                                           _mm256_mul_pd(_mm256_set1_pd(0.25), y2), _CMP_LE_OQ);
+    const __m256d xb = _mm256_add_pd(x, _mm256_set1_pd(1.0));
+    const __m256d bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(xb, xb), y2), _mm256_set1_pd(0.0625), _CMP_LE_OQ);
+    return _mm256_or_pd(cardioid, bulb);
+}
+} // namespace
+
+SIMD_TARGET("avx2,fma")
+void escapeDoubleRowAVX2(const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    const uint lanes = 4;
+    const __m256d scaleX = _mm256_set1_pd(pixelWidth(view, view.scale));
+    const __m256d centerX = _mm256_set1_pd(view.centerX);
+    const __m256d cy = _mm256_set1_pd(static_cast<double>(posY) * pixelHeight(view, view.scale) + view.centerY);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const bool shapeCheck = (view.features & FEATURE_SHAPE_CHECK) != 0;
+    const bool periodicity = (view.features & FEATURE_PERIODICITY) != 0;
+    const __m256d periodicityEpsilon = _mm256_set1_pd(PERIODICITY_EPSILON_D);
+    const bool derivative = (view.features & FEATURE_DERIVATIVE) != 0;
+    const __m256d derivativeEpsilon = _mm256_set1_pd(static_cast<double>(DERIVATIVE_EPSILON));
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d maxIters = _mm256_castsi256_pd(_mm256_set1_epi64x(view.iters));
+
+    for (uint first = 0; first < count; first += lanes)
+    {
+        const uint valid = std::min(lanes, count - first);
+
+        // Lanes past the end of the row are disabled from the start
+        alignas(32) double px[lanes] = {0.0, 0.0, 0.0, 0.0};
+        alignas(32) int64_t enabled[lanes] = {0, 0, 0, 0};
+        for (uint l = 0; l < valid; ++l)
+        {
+            px[l] = static_cast<double>(posX[first + l]);
+            enabled[l] = -1;
+        }
+
+        const __m256d cx = _mm256_add_pd(_mm256_mul_pd(_mm256_load_pd(px), scaleX), centerX);
+        __m256d active = _mm256_castsi256_pd(_mm256_load_si256(reinterpret_cast<const __m256i *>(enabled)));
+        __m256i iters = _mm256_setzero_si256(); // per lane iteration counter
+        __m256d norms = _mm256_setzero_pd();    // per lane |z|^2 at escape
+
+        // Lanes inside the main cardioid or the period-2 bulb are done from the start
+        if (shapeCheck)
+        {
+            const __m256d inside = _mm256_and_pd(insideCardioidOrBulb(cx, cy), active);
+            active = _mm256_andnot_pd(inside, active);
+            iters = _mm256_castpd_si256(_mm256_and_pd(inside, maxIters));
+        }
+
+        // All lanes start together, so they share the checkpoint schedule
+        PeriodicityCheckpoint checkpoint;
+        __m256d checkX = cx;
+        __m256d checkY = cy;
+
+        // dz_n/dz_1, same operation order as escapeDouble()
+        __m256d dzx = _mm256_set1_pd(1.0);
+        __m256d dzy = _mm256_setzero_pd();
+
+        __m256d x = cx;
+        __m256d y = cy;
+        // Whether all lanes are done is only checked every ESCAPE_UNROLL iterations : meanwhile,
+        // the finished lanes go on iterating, masked out of the results
+        for (uint i = 0; i < view.iters && _mm256_movemask_pd(active) != 0;)
+        {
+            const uint blockEnd = std::min(view.iters, i + ESCAPE_UNROLL);
+            for (; i < blockEnd; ++i)
+            {
+                if (derivative)
+                {
+                    const __m256d ndzx = _mm256_mul_pd(two, _mm256_sub_pd(_mm256_mul_pd(x, dzx), _mm256_mul_pd(y, dzy)));
+                    dzy = _mm256_mul_pd(two, _mm256_add_pd(_mm256_mul_pd(x, dzy), _mm256_mul_pd(y, dzx)));
+                    dzx = ndzx;
+                }
+
+                // z = z^2 + c, same operation order as escapeDouble()
+                const __m256d nx = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)), cx);
+                const __m256d ny = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(x, x), y), cy);
+                x = nx;
+                y = ny;
+
+                const __m256d norm = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+                const __m256d escaped = _mm256_and_pd(_mm256_cmp_pd(norm, four, _CMP_GT_OQ), active);
+
+                norms = _mm256_blendv_pd(norms, norm, escaped);
+                active = _mm256_andnot_pd(escaped, active);
+
+                if (periodicity)
+                {
+                    // Lanes back to their checkpoint are in the set
+                    const __m256d dx = _mm256_sub_pd(x, checkX);
+                    const __m256d dy = _mm256_sub_pd(y, checkY);
+                    const __m256d dist = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+                    const __m256d periodic = _mm256_and_pd(_mm256_cmp_pd(dist, periodicityEpsilon, _CMP_LT_OQ), active);
+                    active = _mm256_andnot_pd(periodic, active);
+                    iters = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(iters), maxIters, periodic));
+                    if (checkpoint.advance())
+                    {
+                        checkX = x;
+                        checkY = y;
+                    }
+                }
+
+                if (derivative)
+                {
+                    // Lanes attracted by a cycle are in the set
+                    const __m256d dz = _mm256_add_pd(_mm256_mul_pd(dzx, dzx), _mm256_mul_pd(dzy, dzy));
+                    const __m256d attracted = _mm256_and_pd(_mm256_cmp_pd(dz, derivativeEpsilon, _CMP_LT_OQ), active);
+                    active = _mm256_andnot_pd(attracted, active);
+                    iters = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(iters), maxIters, attracted));
+                }
+
+                // Lanes still running count one more iteration (active lanes are all ones = -1)
+                iters = _mm256_sub_epi64(iters, _mm256_castpd_si256(active));
+            }
+        }
+
+        alignas(32) int64_t outIters[lanes];
+        alignas(32) double outNorms[lanes];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(outIters), iters);
+        _mm256_store_pd(outNorms, norms);
+        for (uint l = 0; l < valid; ++l)
+        {
+            const uint it = static_cast<uint>(outIters[l]);
+            results[first + l] = EscapeResult{it, it < view.iters ? static_cast<float>(outNorms[l]) : 0.f};
+        }
+    }
+}
+
+// Batches of 8 floatfloats : each batch operation is a few 256-bit instructions
+SIMD_TARGET("avx2,fma")
+void escapeFloatFloatRowAVX2(const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    const uint lanes = 8;
+    for (uint first = 0; first < count; first += lanes)
+    {
+        escapeFloatFloatBatch<lanes>(posX + first, posY, std::min(lanes, count - first), view, results + first);
+    }
+}
+
+// escapeDoubleDouble() itself : std::fma compiles to a single instruction here, instead of a library call
+SIMD_TARGET("avx2,fma")
+void escapeDoubleDoubleRowFMA(const float *posX, float posY, uint count, const View &view, const ComplexDD &center,
+                              EscapeResult *results)
+{
+    for (uint i = 0; i < count; ++i)
+    {
+        results[i] = escapeDoubleDouble(posX[i], posY, view, center);
+    }
+}
+
+#else
+
+void escapeDoubleRowAVX2(const float *, float, uint, const View &, EscapeResult *)
+{
+    CORE_ASSERT(false, "AVX2 kernel not available in this build");
+}
+
+void escapeFloatFloatRowAVX2(const float *, float, uint, const View &, EscapeResult *)
+{
+    CORE_ASSERT(false, "AVX2 kernel not available in this build");
+}
+
+void escapeDoubleDoubleRowFMA(const float *, float, uint, const View &, const ComplexDD &, EscapeResult *)
+{
+    CORE_ASSERT(false, "FMA kernel not available in this build");
+}
+
+#endif
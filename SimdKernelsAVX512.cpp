@@ -0,0 +1,169 @@
+// Functions compiled with AVX-512 enabled (SIMD_TARGET). Only called when the CPU supports it.
+#include "SimdKernels.hpp"
+
+#ifdef SIMD_X86
+
+#include <immintrin.h>
+#include <algorithm>
+
+namespace
+{
+// Vector version of inMainCardioidOrBulb(), for the lanes in `mask`
+SIMD_TARGET("avx512f")
+__mmask8 insideCardioidOrBulb(__mmask8 mask, __m512d x, __m512d y)
+{
+    const __m512d xq = _mm512_sub_pd(x, _mm512_set1_pd(0.25));
+    const __m512d y2 = _mm512_mul_pd(y, y);
+    const __m512d q = _mm512_add_pd(_mm512_mul_pd(xq, xq), y2);
+    const __mmask8 cardioid = _mm512_mask_cmp_pd_mask(mask, _mm512_mul_pd(q, _mm512_add_pd(q, xq)),
+                                                      _mm512_mul_pd(_mm512_set1_pd(0.25), y2), _CMP_LE_OQ);
+    const __m512d xb = _mm512_add_pd(x, _mm512_set1_pd(1.0));
+    const __mmask8 bulb = _mm512_mask_cmp_pd_mask(mask, _mm512_add_pd(_mm512_mul_pd(xb, xb), y2), _mm512_set1_pd(0.0625), _CMP_LE_OQ);
+    return static_cast<__mmask8>(cardioid | bulb);
+}
+} // namespace
+
+SIMD_TARGET("avx512f")
+void escapeDoubleRowAVX512(const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    const uint lanes = 8;
+    const __m512d scaleX = _mm512_set1_pd(pixelWidth(view, view.scale));
+    const __m512d centerX = _mm512_set1_pd(view.centerX);
+    const __m512d cy = _mm512_set1_pd(static_cast<double>(posY) * pixelHeight(view, view.scale) + view.centerY);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512i one = _mm512_set1_epi64(1);
+    const bool shapeCheck = (view.features & FEATURE_SHAPE_CHECK) != 0;
+    const bool periodicity = (view.features & FEATURE_PERIODICITY) != 0;
+    const __m512d periodicityEpsilon = _mm512_set1_pd(PERIODICITY_EPSILON_D);
+    const bool derivative = (view.features & FEATURE_DERIVATIVE) != 0;
+    const __m512d derivativeEpsilon = _mm512_set1_pd(static_cast<double>(DERIVATIVE_EPSILON));
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512i maxIters = _mm512_set1_epi64(view.iters);
+
+    for (uint first = 0; first < count; first += lanes)
+    {
+        const uint valid = std::min(lanes, count - first);
+
+        // Lanes past the end of the row are disabled from the start
+        alignas(64) double px[lanes] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        for (uint l = 0; l < valid; ++l)
+        {
+            px[l] = static_cast<double>(posX[first + l]);
+        }
+
+        const __m512d cx = _mm512_add_pd(_mm512_mul_pd(_mm512_load_pd(px), scaleX), centerX);
+        __mmask8 active = static_cast<__mmask8>((1u << valid) - 1u);
+        __m512i iters = _mm512_setzero_si512(); // per lane iteration counter
+        __m512d norms = _mm512_setzero_pd();    // per lane |z|^2 at escape
+
+        // Lanes inside the main cardioid or the period-2 bulb are done from the start
+        if (shapeCheck)
+        {
+            const __mmask8 inside = insideCardioidOrBulb(active, cx, cy);
+            active = static_cast<__mmask8>(active & ~inside);
+            iters = _mm512_mask_mov_epi64(iters, inside, maxIters);
+        }
+
+        // All lanes start together, so they share the checkpoint schedule
+        PeriodicityCheckpoint checkpoint;
+        __m512d checkX = cx;
+        __m512d checkY = cy;
+
+        // dz_n/dz_1, same operation order as escapeDouble()
+        __m512d dzx = _mm512_set1_pd(1.0);
+        __m512d dzy = _mm512_setzero_pd();
+
+        __m512d x = cx;
+        __m512d y = cy;
+        // Whether all lanes are done is only checked every ESCAPE_UNROLL iterations : meanwhile,
+        // the finished lanes go on iterating, masked out of the results
+        for (uint i = 0; i < view.iters && active != 0;)
+        {
+            const uint blockEnd = std::min(view.iters, i + ESCAPE_UNROLL);
+            for (; i < blockEnd; ++i)
+            {
+                if (derivative)
+                {
+                    const __m512d ndzx = _mm512_mul_pd(two, _mm512_sub_pd(_mm512_mul_pd(x, dzx), _mm512_mul_pd(y, dzy)));
+                    dzy = _mm512_mul_pd(two, _mm512_add_pd(_mm512_mul_pd(x, dzy), _mm512_mul_pd(y, dzx)));
+                    dzx = ndzx;
+                }
+
+                // z = z^2 + c, same operation order as escapeDouble()
+                const __m512d nx = _mm512_add_pd(_mm512_sub_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)), cx);
+                const __m512d ny = _mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(x, x), y), cy);
+                x = nx;
+                y = ny;
+
+                const __m512d norm = _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y));
+                const __mmask8 escaped = _mm512_mask_cmp_pd_mask(active, norm, four, _CMP_GT_OQ);
+
+                norms = _mm512_mask_blend_pd(escaped, norms, norm);
+                active = static_cast<__mmask8>(active & ~escaped);
+
+                if (periodicity)
+                {
+                    // Lanes back to their checkpoint are in the set
+                    const __m512d dx = _mm512_sub_pd(x, checkX);
+                    const __m512d dy = _mm512_sub_pd(y, checkY);
+                    const __m512d dist = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+                    const __mmask8 periodic = _mm512_mask_cmp_pd_mask(active, dist, periodicityEpsilon, _CMP_LT_OQ);
+                    active = static_cast<__mmask8>(active & ~periodic);
+                    iters = _mm512_mask_mov_epi64(iters, periodic, maxIters);
+                    if (checkpoint.advance())
+                    {
+                        checkX = x;
+                        checkY = y;
+                    }
+                }
+
+                if (derivative)
+                {
+                    // Lanes attracted by a cycle are in the set
+                    const __m512d dz = _mm512_add_pd(_mm512_mul_pd(dzx, dzx), _mm512_mul_pd(dzy, dzy));
+                    const __mmask8 attracted = _mm512_mask_cmp_pd_mask(active, dz, derivativeEpsilon, _CMP_LT_OQ);
+                    active = static_cast<__mmask8>(active & ~attracted);
+                    iters = _mm512_mask_mov_epi64(iters, attracted, maxIters);
+                }
+
+                // Lanes still running count one more iteration
+                iters = _mm512_mask_add_epi64(iters, active, iters, one);
+            }
+        }
+
+        alignas(64) int64_t outIters[lanes];
+        alignas(64) double outNorms[lanes];
+        _mm512_store_si512(outIters, iters);
+        _mm512_store_pd(outNorms, norms);
+        for (uint l = 0; l < valid; ++l)
+        {
+            const uint it = static_cast<uint>(outIters[l]);
+            results[first + l] = EscapeResult{it, it < view.iters ? static_cast<float>(outNorms[l]) : 0.f};
+        }
+    }
+}
+
+// Batches of 16 floatfloats : each batch operation is a few 512-bit instructions
+SIMD_TARGET("avx512f")
+void escapeFloatFloatRowAVX512(const float *posX, float posY, uint count, const View &view, EscapeResult *results)
+{
+    const uint lanes = 16;
+    for (uint first = 0; first < count; first += lanes)
+    {
+        escapeFloatFloatBatch<lanes>(posX + first, posY, std::min(lanes, count - first), view, results + first);
+    }
+}
+
+#else
+
+void escapeDoubleRowAVX512(const float *, float, uint, const View &, EscapeResult *)
+{
+    CORE_ASSERT(false, "AVX-512 kernel not available in this build");
+}
+
+void escapeFloatFloatRowAVX512(const float *, float, uint, const View &, EscapeResult *)
+{
+    CORE_ASSERT(false, "AVX-512 kernel not available in this build");
+}
+
+#endif
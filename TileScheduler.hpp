@@ -0,0 +1,215 @@
+#ifndef TILESCHEDULER_HPP_
+#define TILESCHEDULER_HPP_
+
+#include <CoreMacros.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Work-stealing scheduler for tasks of very uneven cost (e.g. tiles of a fractal).
+/// Each worker starts with a contiguous range of tasks in its own deque and pops them
+/// from the back. When its deque is empty, it steals from the front of the other
+/// workers' deques, so that no core stays idle while another one has work left.
+/// The worker threads are started once and reused by every run() : they wait for the next
+/// run on a condition variable, and the last one to run out of tasks wakes the caller up.
+/// A run can also go on in the background while the caller does something else (see start()).
+class TileScheduler
+{
+  public:
+    /// Create a scheduler using the given number of threads (0 = one per core)
+    explicit TileScheduler(uint threads = 0)
+        : m_threadCount(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+          m_queues(m_threadCount)
+    {
+        m_threads.reserve(m_threadCount);
+        for (uint t = 0; t < m_threadCount; ++t)
+        {
+            m_threads.emplace_back(&TileScheduler::workerLoop, this, t);
+        }
+    }
+
+    ~TileScheduler()
+    {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_startCondition.notify_all();
+        for (auto &t : m_threads)
+        {
+            t.join();
+        }
+    }
+
+    TileScheduler(const TileScheduler &) = delete;
+    TileScheduler &operator=(const TileScheduler &) = delete;
+
+    /// Number of worker threads
+    uint getThreadCount() const { return m_threadCount; }
+
+    /// Call task(i) for every i in [0, taskCount), and return when all tasks are done.
+    /// `task` is called concurrently from the worker threads. Runs don't overlap : a task must not
+    /// call run() on the same scheduler.
+    template <typename Task>
+    void run(uint taskCount, const Task &task)
+    {
+        if (m_threadCount == 1)
+        {
+            CORE_ASSERT(isDone(), "Overlapping runs");
+            for (uint i = 0; i < taskCount; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+        launch(taskCount, [&task](uint index) { task(index); });
+        wait();
+    }
+
+    /// Start calling task(i) for every i in [0, taskCount) on the worker threads, and return at once.
+    /// `task` is copied. The run is over when isDone(), and the next one must not start before.
+    template <typename Task>
+    void start(uint taskCount, const Task &task)
+    {
+        launch(taskCount, task);
+    }
+
+    /// True when all the tasks of the last run are done
+    bool isDone()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_busyWorkers == 0;
+    }
+
+    /// Wait for all the tasks of the last run
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+        m_task = nullptr;
+    }
+
+  private:
+    /// Deque of task indices owned by one worker
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<uint> tasks;
+
+        // Owner side
+        bool popBack(uint &index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+            {
+                return false;
+            }
+            index = tasks.back();
+            tasks.pop_back();
+            return true;
+        }
+
+        // Thief side
+        bool popFront(uint &index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+            {
+                return false;
+            }
+            index = tasks.front();
+            tasks.pop_front();
+            return true;
+        }
+    };
+
+    /// Hand the tasks [0, taskCount) out to the workers and wake them up
+    void launch(uint taskCount, std::function<void(uint)> task)
+    {
+        if (taskCount == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CORE_ASSERT(m_busyWorkers == 0, "Overlapping runs");
+        for (uint t = 0; t < m_threadCount; ++t)
+        {
+            const uint start = uint(uint64(taskCount) * t / m_threadCount);
+            const uint stop = uint(uint64(taskCount) * (t + 1) / m_threadCount);
+            for (uint i = start; i < stop; ++i)
+            {
+                m_queues[t].tasks.push_back(i);
+            }
+        }
+        m_task = std::move(task);
+        m_busyWorkers = m_threadCount;
+        ++m_run;
+        m_startCondition.notify_all();
+    }
+
+    /// Worker t : run the tasks of each run, until the scheduler is destroyed
+    void workerLoop(uint t)
+    {
+        uint64 lastRun = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_startCondition.wait(lock, [this, lastRun] { return m_stop || m_run != lastRun; });
+                if (m_stop)
+                {
+                    return;
+                }
+                lastRun = m_run;
+            }
+
+            uint index;
+            while (m_queues[t].popBack(index) || steal(m_queues, t, index))
+            {
+                m_task(index);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busyWorkers == 0)
+            {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    /// Try to steal a task from the other workers, starting with the next one.
+    /// Tasks are never added during a run, so when every deque is empty the run is done.
+    static bool steal(std::vector<TaskQueue> &queues, uint thief, uint &index)
+    {
+        const uint n = uint(queues.size());
+        for (uint k = 1; k < n; ++k)
+        {
+            if (queues[(thief + k) % n].popFront(index))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    uint m_threadCount;
+    std::vector<TaskQueue> m_queues; // one per worker, filled by run()
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex; // guards the members below
+    std::condition_variable m_startCondition; // workers wait for the next run, or m_stop
+    std::condition_variable m_doneCondition;  // wait() waits for m_busyWorkers to reach 0
+    std::function<void(uint)> m_task;         // task of the current run
+    uint64 m_run{0};                          // runs started so far
+    uint m_busyWorkers{0};                    // workers still running tasks of the current run
+    bool m_stop{false};
+};
+
+#endif // TILESCHEDULER_HPP_
@@ -0,0 +1,169 @@
+#ifndef VIEW_HPP_
+#define VIEW_HPP_
+
+#include <CoreMacros.hpp>
+#include <cmath>
+
+#include "BigFixed.hpp"
+
+// Shaders available
+enum ShaderType
+{
+    SHADER_FLOAT = 0,  // Basic shader with floating-point precision
+    SHADER_FLOATFLOAT, // Double precision emulation with 2 floats
+    SHADER_DOUBLE,       // True double precision
+    SHADER_QUADFLOAT,    // Quadruple precision emulation with 4 floats
+    SHADER_DOUBLEDOUBLE, // Quadruple precision emulation with 2 doubles (CPU only)
+    SHADER_PERTURBATION, // Deep zoom by perturbation of a reference orbit (CPU only)
+    MAX_SHADERS          // Total number of available shaders
+};
+
+/// True for the modes computed by the CPU renderer, and displayed as a texture
+inline bool isCpuShader(ShaderType shader)
+{
+    return shader == SHADER_DOUBLEDOUBLE || shader == SHADER_PERTURBATION;
+}
+
+/// Name of a shader, as given to --shader
+inline const char *shaderName(ShaderType shader)
+{
+    switch (shader)
+    {
+    case SHADER_FLOAT:
+        return "float";
+    case SHADER_FLOATFLOAT:
+        return "floatfloat";
+    case SHADER_DOUBLE:
+        return "double";
+    case SHADER_QUADFLOAT:
+        return "quadfloat";
+    case SHADER_DOUBLEDOUBLE:
+        return "doubledouble";
+    case SHADER_PERTURBATION:
+        return "perturbation";
+    default:
+        CORE_ASSERT(false, "should not get here");
+    }
+    return "";
+}
+
+// Automatic precision : the ladder of modes from the cheapest to the most precise, with the
+// mantissa bits of each. A mode is precise enough while a pixel spans PRECISION_GUARD_BITS
+// more than the ulp of the orbit values (|z| <= 2 before escaping).
+const ShaderType PRECISION_LADDER[] = {SHADER_FLOAT, SHADER_FLOATFLOAT, SHADER_DOUBLE, SHADER_PERTURBATION};
+const double PRECISION_LADDER_BITS[] = {24.0, 46.0, 53.0, HUGE_VAL};
+const uint PRECISION_LADDER_SIZE = sizeof(PRECISION_LADDER) / sizeof(PRECISION_LADDER[0]);
+const double PRECISION_GUARD_BITS = 4.0;
+const double PRECISION_HYSTERESIS_BITS = 2.0; // spare bits needed to move down the ladder (zoom out x4)
+
+/// Bits of mantissa needed to tell apart the pixels of a view : log2(|z| max / pixel size)
+inline double requiredPrecisionBits(const FloatExp &scale, uint height)
+{
+    // A pixel spans 2 * scale / height
+    return std::log2(double(height)) - scale.log2() + PRECISION_GUARD_BITS;
+}
+
+/// Cheapest mode of the ladder precise enough for the view. Moving up happens as soon as the
+/// current mode is not precise enough, but moving down from `current` needs PRECISION_HYSTERESIS_BITS
+/// to spare : zooming back and forth around a threshold doesn't switch modes at every frame.
+/// A `current` mode out of the ladder is simply replaced.
+inline ShaderType selectPrecision(ShaderType current, const FloatExp &scale, uint height)
+{
+    const double needed = requiredPrecisionBits(scale, height);
+    uint level = 0;
+    while (level + 1 < PRECISION_LADDER_SIZE && PRECISION_LADDER_BITS[level] < needed)
+    {
+        ++level;
+    }
+
+    for (uint l = level; l < PRECISION_LADDER_SIZE; ++l)
+    {
+        if (PRECISION_LADDER[l] == current)
+        {
+            // Stay on the current mode unless a cheaper one has enough spare bits
+            uint lower = level;
+            while (lower < l && PRECISION_LADDER_BITS[lower] < needed + PRECISION_HYSTERESIS_BITS)
+            {
+                ++lower;
+            }
+            return PRECISION_LADDER[lower];
+        }
+    }
+    return PRECISION_LADDER[level];
+}
+
+/// Optional optimizations of the escape-time kernels, as a bit field.
+/// Same values as the constants of Interior.glsl, passed to the shaders' `features` uniform
+enum KernelFeature
+{
+    FEATURE_SHAPE_CHECK = 1 << 0, // Skip points inside the main cardioid and the period-2 bulb
+    FEATURE_PERIODICITY = 1 << 1, // Stop iterating when the orbit comes back to a checkpoint
+    FEATURE_DERIVATIVE = 1 << 2,  // Stop iterating when the orbit is attracted by a cycle (|dz/dz1| -> 0)
+
+    DEFAULT_FEATURES = FEATURE_SHAPE_CHECK | FEATURE_PERIODICITY | FEATURE_DERIVATIVE
+};
+
+/// Parameters of a view of the Mandelbrot set, shared by the GL and CPU renderers
+struct View
+{
+    // The pixels are laid on a lattice around the center point : c = center + position * pixel size, see
+    // pixelPosition() and pixelWidth(). Panning by whole pixels moves the origin, not the center point,
+    // so the pixels kept on screen keep exactly the same c.
+    double centerX{-0.5}; // center point x
+    double centerY{0.0};  // center point y
+
+    BigFixed preciseCenterX{-0.5}; // center point x with arbitrary precision (perturbation)
+    BigFixed preciseCenterY{0.0};  // center point y with arbitrary precision (perturbation)
+
+    double scale{2};      // zoom level, 0 past the double range
+    FloatExp preciseScale{2.0}; // zoom level without range limit (perturbation)
+    double ratio{1.0};    // aspect ratio
+    uint iters{1000};     // max number of Mandelbrot function iterations
+    uint features{DEFAULT_FEATURES}; // enabled KernelFeature bits
+    uint seriesTerms{8};  // terms of the perturbation series approximation (0 = disabled)
+    bool bilinearApproximation{true}; // skip perturbation steps with the BLA table
+
+    uint width{800};  // image width in pixels
+    uint height{800}; // image height in pixels
+    int originX{0};   // center of the image, in pixels right of the center point
+    int originY{0};   // center of the image, in pixels above the center point
+};
+
+/// Position along an axis of n pixels of the point `x` pixels from its left (or bottom) edge, in pixels from
+/// the center point, `origin` being the position of the image center. Pixel centers are at x = i + 0.5,
+/// as gl_FragCoord : the shaders get `origin - n / 2` as their `offset` uniform. Exact in float, so a pixel
+/// has the same position whatever the origin of the view it is in.
+inline float axisPosition(float x, uint n, int origin)
+{
+    return x + (static_cast<float>(origin) - 0.5f * static_cast<float>(n));
+}
+
+/// Position of the center of pixel i, counted from the left (or bottom) of an axis of n pixels
+inline float pixelPosition(uint i, uint n, int origin)
+{
+    return axisPosition(static_cast<float>(i) + 0.5f, n, origin);
+}
+
+/// Width of a pixel in the complex plane at the given scale : the view's, or 1 for the deltas
+/// in units of the scale (ratio is a float uniform)
+inline double pixelWidth(const View &view, double scale)
+{
+    return 2.0 * scale * static_cast<double>(static_cast<float>(view.ratio)) / view.width;
+}
+
+/// Height of a pixel in the complex plane at the given scale
+inline double pixelHeight(const View &view, double scale)
+{
+    return 2.0 * scale / view.height;
+}
+
+inline bool operator==(const View &a, const View &b)
+{
+    return a.centerX == b.centerX && a.centerY == b.centerY && a.preciseCenterX == b.preciseCenterX &&
+           a.preciseCenterY == b.preciseCenterY && a.scale == b.scale && a.preciseScale == b.preciseScale &&
+           a.ratio == b.ratio && a.iters == b.iters && a.features == b.features && a.seriesTerms == b.seriesTerms &&
+           a.bilinearApproximation == b.bilinearApproximation && a.width == b.width && a.height == b.height &&
+           a.originX == b.originX && a.originY == b.originY;
+}
+
+#endif // VIEW_HPP_
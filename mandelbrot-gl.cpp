@@ -16,8 +16,10 @@
 #include <cinttypes>
 #include <chrono>
 #include <algorithm>
+#include <cmath>
 
 #include <fstream>
+#include <cstring>
 
 #define STBI_MSC_SECURE_CRT
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -28,6 +30,11 @@
 
 #include "Shader.hpp"
 #include "FloatFloat.hpp"
+#include "QuadFloat.hpp"
+#include "BigFixed.hpp"
+#include "View.hpp"
+#include "CpuRenderer.hpp"
+#include "Palette.hpp"
 
 // glfw callbacks
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
@@ -37,48 +44,141 @@ void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, in
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
 
-// Shaders available
-enum ShaderType
-{
-    SHADER_FLOAT = 0,  // Basic shader with floating-point precision
-    SHADER_FLOATFLOAT, // Double precision emulation with 2 floats
-    SHADER_DOUBLE,     // True double precision
-    MAX_SHADERS        // Total number of available shaders
-};
+// Time spent per frame computing again the pixels of a zoom preview
+const double REFINE_FRAME_BUDGET_MS = 20.0;
 
 // Container for the uniforms of a shader
 struct Uniforms
 {
-    GLint centerUniform;   // center coordinates
+    GLint centerUniform;   // center point coordinates
     GLint scaleUniform;    // zoom level
-    GLint ratioUniform;    // aspect ratio
+    GLint pixelUniform;    // size of a pixel
+    GLint offsetUniform;   // offset from gl_FragCoord to the pixel positions (see pixelPosition())
     GLint maxItersUniform; // max number of mandelbrot function iterations
+    GLint featuresUniform; // enabled kernel optimizations
+};
+
+// Uniforms of the coloring pass (Color.glsl)
+struct ColorUniforms
+{
+    GLint fieldUniform;   // iteration field texture
+    GLint maxItersUniform; // max number of iterations of the field
+    GLint palettesUniform;      // texture array of all the palettes
+    GLint paletteIndexUniform;  // layer of the current palette
+    GLint paletteSizeUniform;   // number of colors of the current palette
+    GLint paletteLogUniform;    // 1 for a palette of the log of the smooth iteration count
+    GLint palettePeriodUniform; // palette cycle, in units of its coordinate
+    GLint paletteOffsetUniform; // palette shift, in cycles
+    GLint equalizeUniform;      // 1 for histogram equalization
+    GLint cdfUniform;           // cumulative histogram of the field (buffer texture)
 };
 
 // Global variable containing the parameters of current view
 struct Context
 {
     // View parameters
-    double centerX{-0.5}; // center point x
-    double centerY{0.0};  // center point y
-    double scale{2};      // zoom level
+    BigFixed centerX{-0.5}; // center point x, with arbitrary precision for deep zooms
+    BigFixed centerY{0.0};  // center point y
+    int originX{0};         // center of the image, in pixels right of the center point (see View)
+    int originY{0};         // center of the image, in pixels above the center point
+    FloatExp scale{2.0};    // zoom level, beyond the double range for deep zooms
     double ratio{1.0};    // aspect ratio
     uint iters{1000};     // max number of Mandelbrot function iterations
+    uint seriesTerms{8};  // terms of the perturbation series approximation (0 = disabled)
+    bool bilinearApproximation{true}; // skip perturbation steps with the BLA table
 
     // Viewport paramters
     uint width {SCR_WIDTH};
     uint height {SCR_HEIGHT};
 
-    // Shaders and related data
+    // Shaders and related data. The CPU shaders have no program : their field is computed by cpuRenderer
     ShaderType current_shader{SHADER_FLOAT};
+    bool autoPrecision{false}; // pick the cheapest shader precise enough for the view (see selectPrecision())
     std::unique_ptr<ShaderProgram> shaders[MAX_SHADERS];
     Uniforms uniforms[MAX_SHADERS];
+    uint features[MAX_SHADERS] {DEFAULT_FEATURES, DEFAULT_FEATURES, DEFAULT_FEATURES, DEFAULT_FEATURES, DEFAULT_FEATURES, DEFAULT_FEATURES}; // KernelFeature bits of each shader
+    std::unique_ptr<CpuRenderer> cpuRenderer;
+
+    // Frames are rendered in two passes : the shaders write the iteration field (iteration and |z|^2
+    // of each pixel) to a float texture, only when the view changes, then colorShader colors it
+    GLuint fieldTexture{0};
+    GLuint fieldFramebuffer{0};
+    bool fieldDirty{true};
+
+    // Panning moves the view by whole pixels, around a fixed center point (originX, originY) : if the view
+    // only moved since the field was computed, the field is scrolled by (panX, panY) (see IterationField::scroll())
+    // and only the exposed strips are computed again. The scrolled pixels are exactly the ones computed anew.
+    // If it was only zoomed, by `zoom`, the field is reprojected (see reprojectZoom()) as a preview, then
+    // computed again by tiles, the least exact ones first : a few per frame by the GL shaders, in the background
+    // by the CPU renderer's workers for the CPU shaders (see refineField()).
+    int panX{0};
+    int panY{0};
+    double zoom{1.0};
+    bool fieldReusable{false};
+    GLuint scrollTexture{0};   // spare field texture, swapped with fieldTexture when scrolling or zooming
+    IterationField cpuField;   // field of the CPU shaders, kept for scrolling and zooming
+    std::vector<float> fieldError;      // distance of each pixel's value to an exact one, in pixels (0 = exact)
+    std::vector<PixelRect> refineTiles; // tiles of the field left to compute, the least exact last
+    uint refineBatch{1};                // GL shaders : tiles computed per frame, adapted to REFINE_FRAME_BUDGET_MS
+    GLuint refineQuery{0};              // GL shaders : timer query of the GPU time of a batch of tiles
+    bool refineQueryPending{false};     // its result is not read yet
+    bool cpuRefining{false};            // CPU shaders : the tiles are being computed by cpuRenderer's workers
+    std::unique_ptr<ShaderProgram> reprojectShader;
+    std::unique_ptr<ShaderProgram> colorShader;
+    ColorUniforms colorUniforms;
+
+    // Colors : the built-in palettes, then the ones loaded from files. They are all uploaded as the
+    // layers of paletteTexture, so switching palettes only changes a uniform.
+    std::vector<Palette> palettes;
+    uint paletteIndex{0};     // current palette
+    float paletteOffset{0.f}; // palette shift, in cycles
+    GLuint paletteTexture{0};
+
+    // Histogram equalization : the cumulative histogram of the field is computed by the CPU
+    // renderer from the field texture, when the field changes
+    bool equalize{false};
+    bool cdfDirty{true};
+    GLuint cdfBuffer{0};
+    GLuint cdfTexture{0};
 
     // Other UI stuff
     bool screenshot{false}; // If true, export the next frame as a png
 
 } g_context;
 
+// Extract the view parameters of a context
+View getView(const Context &context)
+{
+    View view;
+    view.centerX = context.centerX.toDouble();
+    view.centerY = context.centerY.toDouble();
+    view.preciseCenterX = context.centerX;
+    view.preciseCenterY = context.centerY;
+    view.scale = context.scale.toDouble();
+    view.preciseScale = context.scale;
+    view.ratio = context.ratio;
+    view.iters = context.iters;
+    view.features = context.features[context.current_shader];
+    view.seriesTerms = context.seriesTerms;
+    view.bilinearApproximation = context.bilinearApproximation;
+    view.width = context.width;
+    view.height = context.height;
+    view.originX = context.originX;
+    view.originY = context.originY;
+    return view;
+}
+
+// Center of the image : the center point, moved by the origin
+BigFixed imageCenterX(const Context &context)
+{
+    return context.centerX + BigFixed(context.scale * FloatExp(pixelWidth(getView(context), 1.0) * context.originX));
+}
+
+BigFixed imageCenterY(const Context &context)
+{
+    return context.centerY + BigFixed(context.scale * FloatExp(pixelHeight(getView(context), 1.0) * context.originY));
+}
+
 std::vector<uchar> grabFrame(uint w, uint h)
 {
     // Bind the front buffer
@@ -123,11 +223,24 @@ void save(const Context &context, const std::string &filename)
     std::string saveString;
 
     // Print the floats to hex to get the exact value
-    saveString += core::double2hex(context.centerX);
+    const BigFixed centerX = imageCenterX(context);
+    const BigFixed centerY = imageCenterY(context);
+    saveString += core::double2hex(centerX.toDouble());
     saveString += " ";
-    saveString += core::double2hex(context.centerY);
+    saveString += core::double2hex(centerY.toDouble());
     saveString += " ";
-    saveString += core::double2hex(context.scale);
+    saveString += core::double2hex(context.scale.toDouble());
+
+    // Second line : the center with its full precision, and the scale as mantissa and exponent.
+    // Older versions only read the first line.
+    saveString += "\n";
+    saveString += centerX.toHexString();
+    saveString += " ";
+    saveString += centerY.toHexString();
+    saveString += " ";
+    saveString += core::double2hex(context.scale.getMantissa());
+    saveString += " ";
+    saveString += std::to_string(context.scale.getExponent());
 
     std::ofstream of{filename};
     CORE_ASSERT(of.good(), "Can't open " << filename);
@@ -136,7 +249,7 @@ void save(const Context &context, const std::string &filename)
 
 void load(Context &context, const std::string &filename)
 {
-    static_assert(sizeof(context.centerX) == sizeof(uint64), "Assuming 64 bits double");
+    static_assert(sizeof(double) == sizeof(uint64), "Assuming 64 bits double");
 
     union {
         double f;
@@ -159,7 +272,23 @@ void load(Context &context, const std::string &filename)
 
     context.centerX = x.f;
     context.centerY = y.f;
+    context.originX = 0;
+    context.originY = 0;
     context.scale = s.f;
+
+    // Full precision center and scale, if the file has them
+    if (std::getline(in, l) && !l.empty())
+    {
+        vec = core::splitString(l, ' ');
+        CORE_ASSERT(vec.size() == 2 || vec.size() == 4, "Incorrect file format");
+        context.centerX = BigFixed::fromHexString(vec[0]);
+        context.centerY = BigFixed::fromHexString(vec[1]);
+        if (vec.size() == 4)
+        {
+            s.i = _strtoui64(vec[2].c_str(), NULL, 16);
+            context.scale = FloatExp(s.f, std::stoll(vec[3]));
+        }
+    }
 }
 
 // Update the shader uniforms
@@ -167,41 +296,60 @@ void updateUniforms(const Context &context)
 {
     CORE_ASSERT(context.current_shader < MAX_SHADERS, "Invalid shader");
     const Uniforms &u = context.uniforms[context.current_shader];
+
+    // The pixel sizes are computed here and given to the shaders, as to the CPU kernels (see Precision.hpp)
+    const View view = getView(context);
+    const double pixelX = pixelWidth(view, view.scale);
+    const double pixelY = pixelHeight(view, view.scale);
+    GL_ASSERT(glUniform2f(u.offsetUniform, axisPosition(0.f, view.width, view.originX),
+                          axisPosition(0.f, view.height, view.originY)));
     switch (context.current_shader)
     {
     case SHADER_FLOAT:
     {
-        GL_ASSERT(glUniform2f(u.centerUniform, static_cast<GLfloat>(context.centerX),
-                              static_cast<GLfloat>(context.centerY)));
-        GL_ASSERT(glUniform1f(u.scaleUniform, static_cast<GLfloat>(context.scale)));
-        GL_ASSERT(glUniform1f(u.ratioUniform, static_cast<GLfloat>(context.ratio)));
+        GL_ASSERT(glUniform2f(u.centerUniform, static_cast<GLfloat>(context.centerX.toDouble()),
+                              static_cast<GLfloat>(context.centerY.toDouble())));
+        GL_ASSERT(glUniform2f(u.pixelUniform, static_cast<GLfloat>(pixelX), static_cast<GLfloat>(pixelY)));
         GL_ASSERT(glUniform1ui(u.maxItersUniform, static_cast<GLuint>(context.iters)));
         break;
     }
     case SHADER_FLOATFLOAT:
     {
-        FloatFloat center[2] = {context.centerX, context.centerY};
-        FloatFloat s(context.scale);
+        FloatFloat center[2] = {context.centerX.toDouble(), context.centerY.toDouble()};
+        FloatFloat pixel[2] = {pixelX, pixelY};
         static_assert(sizeof(center) == 4 * sizeof(float), "Size/align problem ");
 
         GL_ASSERT(glUniform4fv(u.centerUniform, 1, center[0].values));
-        GL_ASSERT(glUniform2fv(u.scaleUniform, 1, s.values));
-        GL_ASSERT(glUniform1f(u.ratioUniform, static_cast<GLfloat>(context.ratio)));
+        GL_ASSERT(glUniform4fv(u.pixelUniform, 1, pixel[0].values));
         GL_ASSERT(glUniform1ui(u.maxItersUniform, static_cast<GLuint>(context.iters)));
         break;
     }
     case SHADER_DOUBLE:
     {
-        GL_ASSERT(glUniform2d(u.centerUniform, static_cast<GLdouble>(context.centerX),
-                              static_cast<GLdouble>(context.centerY)));
-        GL_ASSERT(glUniform1d(u.scaleUniform, static_cast<GLdouble>(context.scale)));
-        GL_ASSERT(glUniform1f(u.ratioUniform, static_cast<GLfloat>(context.ratio)));
+        GL_ASSERT(glUniform2d(u.centerUniform, static_cast<GLdouble>(context.centerX.toDouble()),
+                              static_cast<GLdouble>(context.centerY.toDouble())));
+        GL_ASSERT(glUniform2d(u.pixelUniform, pixelX, pixelY));
+        GL_ASSERT(glUniform1ui(u.maxItersUniform, static_cast<GLuint>(context.iters)));
+        break;
+    }
+    case SHADER_QUADFLOAT:
+    {
+        // The center keeps its arbitrary precision up to the 96 bits of the quadfloats
+        QuadFloat center[2] = {QuadFloat(context.centerX), QuadFloat(context.centerY)};
+        QuadFloat pixel[2] = {QuadFloat(pixelX), QuadFloat(pixelY)};
+        QuadFloat s(context.scale.toDouble());
+        static_assert(sizeof(center) == 8 * sizeof(float), "Size/align problem ");
+
+        GL_ASSERT(glUniform4fv(u.centerUniform, 2, center[0].values));
+        GL_ASSERT(glUniform4fv(u.scaleUniform, 1, s.values));
+        GL_ASSERT(glUniform4fv(u.pixelUniform, 2, pixel[0].values));
         GL_ASSERT(glUniform1ui(u.maxItersUniform, static_cast<GLuint>(context.iters)));
         break;
     }
     default:
         CORE_ASSERT(false, "should not get here");
     }
+    GL_ASSERT(glUniform1ui(u.featuresUniform, static_cast<GLuint>(context.features[context.current_shader])));
 }
 
 using ns_clock = std::chrono::high_resolution_clock;
@@ -224,6 +372,13 @@ class FPSMonitor
         renderTime += ns_clock::duration(render - update).count();
         swapTime += ns_clock::duration(swap - render).count();
         uiTime += ns_clock::duration(end - swap).count();
+        if (frameSkipped)
+        {
+            skippedIters += frameSkippedIters;
+            ++skippedFrames;
+            frameSkippedIters = 0;
+            frameSkipped = false;
+        }
         if (++frameCounter == avgFrames)
         {
             print();
@@ -245,9 +400,21 @@ class FPSMonitor
         f("Render", renderTime);
         f("Swap  ", swapTime);
         f("UI    ", uiTime);
+        if (skippedFrames > 0)
+        {
+            std::cout << "Skipped    " << skippedIters / skippedFrames << " iterations per frame (series)" << std::endl;
+        }
         std::cout << std::endl;
     }
 
+    /// Iterations skipped by the series approximation in a part of the field computed on the CPU. The parts
+    /// computed for the same displayed frame are summed, and counted as one frame by report()
+    void reportSkipped(uint64 iters)
+    {
+        frameSkippedIters += iters;
+        frameSkipped = true;
+    }
+
     void setAvgFrames(uint avg)
     {
         // ensure we average over at least one frame
@@ -263,6 +430,10 @@ class FPSMonitor
         renderTime = 0;
         swapTime = 0;
         uiTime = 0;
+        skippedIters = 0;
+        skippedFrames = 0;
+        frameSkippedIters = 0;
+        frameSkipped = false;
     }
 
   private:
@@ -272,12 +443,722 @@ class FPSMonitor
     uint64 renderTime;
     uint64 swapTime;
     uint64 uiTime;
+    uint64 skippedIters;
+    uint skippedFrames;
+    uint64 frameSkippedIters; // summed over the current frame, until report()
+    bool frameSkipped;
 };
 
 FPSMonitor g_monitor(100);
 
-int main()
+// The iteration field must be computed again from scratch
+void invalidateField(Context &context)
+{
+    context.fieldDirty = true;
+    context.fieldReusable = false;
+}
+
+// Move the center point to the center of the image. The pixels move off the lattice of the field :
+// it can't be scrolled any more.
+void recenter(Context &context)
 {
+    context.centerX = imageCenterX(context);
+    context.centerY = imageCenterY(context);
+    context.originX = 0;
+    context.originY = 0;
+}
+
+// Move the view by whole pixels, to the right (dx) and down (dy) : the center point stays, so the pixels
+// of the field keep exactly their value, only shifted. The perturbation pixels also depend on the frame
+// (series per tile, glitch references) : they are computed again, around the new center.
+void panView(Context &context, int dx, int dy)
+{
+    context.originX += dx;
+    context.originY -= dy;
+    context.panX += dx;
+    context.panY += dy;
+    context.fieldDirty = true;
+    if (context.zoom != 1.0)
+    {
+        invalidateField(context);
+    }
+    if (context.current_shader == SHADER_PERTURBATION)
+    {
+        recenter(context);
+        invalidateField(context);
+    }
+}
+
+// Multiply the scale by `factor`, around the center of the image : the field is previewed by reprojection
+void zoomView(Context &context, float factor)
+{
+    recenter(context);
+    context.scale *= factor;
+    context.zoom *= factor;
+    context.fieldDirty = true;
+    if (context.panX != 0 || context.panY != 0)
+    {
+        invalidateField(context);
+    }
+}
+
+// Automatic precision : switch to the cheapest shader precise enough for the current view
+void updateAutoPrecision(Context &context)
+{
+    const ShaderType shader = selectPrecision(context.current_shader, context.scale, context.height);
+    if (shader != context.current_shader)
+    {
+        std::cout << " auto precision : switching from " << shaderName(context.current_shader) << " to "
+                  << shaderName(shader) << " at scale " << context.scale.toString() << " ("
+                  << requiredPrecisionBits(context.scale, context.height) << " bits needed)" << std::endl;
+        context.current_shader = shader;
+        invalidateField(context);
+        g_monitor.reset();
+    }
+}
+
+// Allocate the iteration field for the window size
+void resizeField(const Context &context)
+{
+    for (GLuint texture : {context.fieldTexture, context.scrollTexture})
+    {
+        GL_ASSERT(glBindTexture(GL_TEXTURE_2D, texture));
+        GL_ASSERT(glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, context.width, context.height, 0, GL_RG, GL_FLOAT, nullptr));
+    }
+}
+
+// Scroll the field texture by (panX, panY) pixels : the kept part is copied to the spare texture,
+// which becomes the field. Returns the pixels left to compute.
+std::vector<PixelRect> scrollFieldTexture(Context &context)
+{
+    const std::vector<PixelRect> exposed =
+        IterationField::exposedPixels(context.width, context.height, context.panX, context.panY);
+    const uint shiftX = static_cast<uint>(std::abs(context.panX));
+    const uint shiftY = static_cast<uint>(std::abs(context.panY));
+    if (shiftX >= context.width || shiftY >= context.height)
+    {
+        return exposed;
+    }
+
+    // GL rows go up : pixel (x, y) takes the value of (x + panX, y - panY)
+    const GLint srcX = context.panX > 0 ? shiftX : 0;
+    const GLint dstX = context.panX > 0 ? 0 : shiftX;
+    const GLint srcY = context.panY > 0 ? 0 : shiftY;
+    const GLint dstY = context.panY > 0 ? shiftY : 0;
+    GL_ASSERT(glCopyImageSubData(context.fieldTexture, GL_TEXTURE_2D, 0, srcX, srcY, 0, context.scrollTexture,
+                                 GL_TEXTURE_2D, 0, dstX, dstY, 0, context.width - shiftX, context.height - shiftY, 1));
+    std::swap(context.fieldTexture, context.scrollTexture);
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, context.fieldFramebuffer));
+    GL_ASSERT(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, context.fieldTexture, 0));
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    return exposed;
+}
+
+// Upload a rectangle of the field of the CPU shaders
+void uploadCpuField(const Context &context, const PixelRect &rect)
+{
+    // The CPU field is stored top row first, GL pixels are numbered from the bottom
+    const IterationField &field = context.cpuField;
+    const uint w = rect.x1 - rect.x0;
+    const uint h = rect.y1 - rect.y0;
+    std::vector<float> texels(2 * w * h);
+    for (uint row = rect.y0; row < rect.y1; ++row)
+    {
+        const uint j = rect.y1 - 1 - row;
+        for (uint i = 0; i < w; ++i)
+        {
+            const uint n = row * field.width + rect.x0 + i;
+            texels[2 * (j * w + i) + 0] = static_cast<float>(field.iters[n]);
+            texels[2 * (j * w + i) + 1] = field.norms[n];
+        }
+    }
+    GL_ASSERT(glBindTexture(GL_TEXTURE_2D, context.fieldTexture));
+    GL_ASSERT(glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x0, field.height - rect.y1, w, h, GL_RG, GL_FLOAT, texels.data()));
+}
+
+// The pixels of the rectangles have their exact value
+void clearFieldError(Context &context, const std::vector<PixelRect> &rects)
+{
+    for (const PixelRect &rect : rects)
+    {
+        for (uint row = rect.y0; row < rect.y1; ++row)
+        {
+            const auto first = context.fieldError.begin() + row * context.width;
+            std::fill(first + rect.x0, first + rect.x1, 0.f);
+        }
+    }
+}
+
+// Compute rectangles of the field with the current shader, keeping the other pixels
+void computeFieldRects(Context &context, const std::vector<PixelRect> &rects)
+{
+    if (isCpuShader(context.current_shader))
+    {
+        IterationField &field = context.cpuField;
+        context.cpuRenderer->renderRects(getView(context), context.current_shader, field, rects);
+        g_monitor.reportSkipped(field.skippedIters);
+        for (const PixelRect &rect : rects)
+        {
+            uploadCpuField(context, rect);
+        }
+    }
+    else
+    {
+        // The rectangles are drawn with the scissor test : the other fragments are not shaded
+        GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, context.fieldFramebuffer));
+        context.shaders[context.current_shader]->useProgram();
+        updateUniforms(context);
+        GL_ASSERT(glEnable(GL_SCISSOR_TEST));
+        for (const PixelRect &rect : rects)
+        {
+            GL_ASSERT(glScissor(rect.x0, context.height - rect.y1, rect.x1 - rect.x0, rect.y1 - rect.y0));
+            GL_ASSERT(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+        }
+        GL_ASSERT(glDisable(GL_SCISSOR_TEST));
+        GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    }
+
+    clearFieldError(context, rects);
+}
+
+// Zoom preview : reproject the field to the new scale
+void reprojectField(Context &context)
+{
+    const std::vector<uint> sources = reprojectZoom(context.width, context.height, context.zoom, context.fieldError);
+    if (isCpuShader(context.current_shader))
+    {
+        context.cpuField.gather(sources);
+        uploadCpuField(context, PixelRect{0, 0, context.width, context.height});
+    }
+    else
+    {
+        // Drawn to the spare texture, which becomes the field
+        GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, context.fieldFramebuffer));
+        GL_ASSERT(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, context.scrollTexture, 0));
+        context.reprojectShader->useProgram();
+        GL_ASSERT(glActiveTexture(GL_TEXTURE0));
+        GL_ASSERT(glBindTexture(GL_TEXTURE_2D, context.fieldTexture));
+        const GLint id = context.reprojectShader->getID();
+        GL_ASSERT(glUniform1i(glGetUniformLocation(id, "previous"), 0));
+        GL_ASSERT(glUniform1f(glGetUniformLocation(id, "zoom"), static_cast<float>(context.zoom)));
+        GL_ASSERT(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+        GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+        std::swap(context.fieldTexture, context.scrollTexture);
+    }
+}
+
+// Sort the tiles of the field that are not exact, the least exact (e.g. without a source) computed first
+void scheduleRefinement(Context &context)
+{
+    const uint tile = CpuRenderer::TILE_SIZE;
+    std::vector<std::pair<float, PixelRect>> tiles;
+    for (uint y0 = 0; y0 < context.height; y0 += tile)
+    {
+        for (uint x0 = 0; x0 < context.width; x0 += tile)
+        {
+            const PixelRect rect{x0, y0, std::min(context.width, x0 + tile), std::min(context.height, y0 + tile)};
+            float error = 0.f;
+            for (uint row = rect.y0; row < rect.y1; ++row)
+            {
+                for (uint col = rect.x0; col < rect.x1; ++col)
+                {
+                    error = std::max(error, context.fieldError[row * context.width + col]);
+                }
+            }
+            if (error > 0.f)
+            {
+                tiles.push_back(std::make_pair(error, rect));
+            }
+        }
+    }
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [](const std::pair<float, PixelRect> &a, const std::pair<float, PixelRect> &b) { return a.first < b.first; });
+    context.refineTiles.clear();
+    for (const auto &t : tiles)
+    {
+        context.refineTiles.push_back(t.second);
+    }
+}
+
+// Stop the tiles being computed in the background before the CPU field or renderer are used otherwise :
+// the finished ones are uploaded, the others scheduled again
+void stopCpuRefinement(Context &context)
+{
+    if (!context.cpuRefining)
+    {
+        return;
+    }
+    std::vector<PixelRect> finished;
+    context.cpuRenderer->cancelRects(finished);
+    context.cpuRefining = false;
+    for (const PixelRect &rect : finished)
+    {
+        uploadCpuField(context, rect);
+    }
+    clearFieldError(context, finished);
+    scheduleRefinement(context);
+}
+
+// First pass : compute the iteration field of the current view with the current shader, or update it
+// from the previous one if the view was only panned or zoomed
+void renderField(Context &context)
+{
+    stopCpuRefinement(context);
+    if (!context.fieldReusable)
+    {
+        context.cpuField.resize(context.width, context.height, context.iters);
+        context.fieldError.assign(context.width * context.height, 0.f);
+        context.refineTiles.clear();
+        computeFieldRects(context, {PixelRect{0, 0, context.width, context.height}});
+    }
+    else if (context.zoom != 1.0)
+    {
+        reprojectField(context);
+        scheduleRefinement(context);
+    }
+    else
+    {
+        // The CPU field is scrolled too, the texture is enough for the GL shaders
+        if (isCpuShader(context.current_shader))
+        {
+            context.cpuField.scroll(context.panX, context.panY);
+        }
+        scrollPixels(context.fieldError.data(), context.width, context.height, context.panX, context.panY);
+        computeFieldRects(context, scrollFieldTexture(context));
+        if (!context.refineTiles.empty())
+        {
+            scheduleRefinement(context);
+        }
+    }
+    context.fieldDirty = false;
+    context.cdfDirty = true;
+    context.panX = 0;
+    context.panY = 0;
+    context.zoom = 1.0;
+    context.fieldReusable = true;
+}
+
+// Compute again the tiles of a zoom preview. The CPU shaders compute all of them on cpuRenderer's workers,
+// and each frame uploads the ones finished. The GL shaders compute as many per frame as fit in
+// REFINE_FRAME_BUDGET_MS of GPU time, as measured by a timer query : its result is read a frame or more
+// later, without waiting for the GPU.
+void refineField(Context &context)
+{
+    if (isCpuShader(context.current_shader))
+    {
+        if (!context.cpuRefining)
+        {
+            context.cpuRenderer->startRects(getView(context), context.current_shader, context.cpuField,
+                                            context.refineTiles);
+            context.refineTiles.clear();
+            context.cpuRefining = true;
+        }
+        std::vector<PixelRect> finished;
+        if (context.cpuRenderer->finishRects(finished))
+        {
+            context.cpuRefining = false;
+            context.cdfDirty = true;
+            g_monitor.reportSkipped(context.cpuField.skippedIters);
+        }
+        for (const PixelRect &rect : finished)
+        {
+            uploadCpuField(context, rect);
+        }
+        clearFieldError(context, finished);
+        return;
+    }
+
+    if (context.refineQueryPending)
+    {
+        GLint available = 0;
+        GL_ASSERT(glGetQueryObjectiv(context.refineQuery, GL_QUERY_RESULT_AVAILABLE, &available));
+        if (available)
+        {
+            GLuint64 ns = 0;
+            GL_ASSERT(glGetQueryObjectui64v(context.refineQuery, GL_QUERY_RESULT, &ns));
+            context.refineQueryPending = false;
+            const double ms = double(ns) * 1e-6;
+            if (ms < 0.5 * REFINE_FRAME_BUDGET_MS)
+            {
+                context.refineBatch *= 2;
+            }
+            else if (ms > REFINE_FRAME_BUDGET_MS)
+            {
+                context.refineBatch = std::max(1u, context.refineBatch / 2);
+            }
+        }
+    }
+
+    std::vector<PixelRect> batch;
+    while (batch.size() < context.refineBatch && !context.refineTiles.empty())
+    {
+        batch.push_back(context.refineTiles.back());
+        context.refineTiles.pop_back();
+    }
+    // Only one batch is timed at once, the next ones keep its size until its time is known
+    const bool timed = !context.refineQueryPending;
+    if (timed)
+    {
+        GL_ASSERT(glBeginQuery(GL_TIME_ELAPSED, context.refineQuery));
+    }
+    computeFieldRects(context, batch);
+    if (timed)
+    {
+        GL_ASSERT(glEndQuery(GL_TIME_ELAPSED));
+        context.refineQueryPending = true;
+    }
+    if (context.refineTiles.empty())
+    {
+        context.cdfDirty = true;
+    }
+}
+
+// Histogram equalization : read the iterations back from the field texture (whichever shader wrote
+// it, without computing them again) and upload their cumulative histogram
+void updateEqualization(Context &context)
+{
+    stopCpuRefinement(context);
+    IterationField field;
+    field.resize(context.width, context.height, context.iters);
+    std::vector<float> iters(context.width * context.height);
+    GL_ASSERT(glBindTexture(GL_TEXTURE_2D, context.fieldTexture));
+    GL_ASSERT(glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, iters.data()));
+    for (uint n = 0; n < iters.size(); ++n)
+    {
+        field.iters[n] = static_cast<uint>(iters[n]);
+    }
+
+    const std::vector<float> cdf = context.cpuRenderer->equalization(field);
+    GL_ASSERT(glBindBuffer(GL_TEXTURE_BUFFER, context.cdfBuffer));
+    GL_ASSERT(glBufferData(GL_TEXTURE_BUFFER, cdf.size() * sizeof(float), cdf.data(), GL_DYNAMIC_DRAW));
+    GL_ASSERT(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_BUFFER, context.cdfTexture));
+    GL_ASSERT(glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, context.cdfBuffer));
+    context.cdfDirty = false;
+}
+
+// Built-in palettes, then the palette NAME|FILE if it's not one of them. Returns its index.
+uint addPalette(Context &context, const std::string &name)
+{
+    if (context.palettes.empty())
+    {
+        for (const char *builtin : BUILTIN_PALETTES)
+        {
+            context.palettes.push_back(builtinPalette(builtin));
+        }
+    }
+    for (uint i = 0; i < context.palettes.size(); ++i)
+    {
+        if (context.palettes[i].name == name)
+        {
+            return i;
+        }
+    }
+    context.palettes.push_back(findPalette(name));
+    return static_cast<uint>(context.palettes.size() - 1);
+}
+
+// Upload the colors of all the palettes, one per layer of a texture array as wide as the largest
+void updatePaletteTexture(const Context &context)
+{
+    static_assert(sizeof(Rgba) == 4 * sizeof(float), "Size/align problem ");
+    size_t width = 0;
+    for (const Palette &palette : context.palettes)
+    {
+        width = std::max(width, palette.colors.size());
+    }
+    const GLsizei layers = static_cast<GLsizei>(context.palettes.size());
+    GL_ASSERT(glBindTexture(GL_TEXTURE_1D_ARRAY, context.paletteTexture));
+    GL_ASSERT(glTexImage2D(GL_TEXTURE_1D_ARRAY, 0, GL_RGBA32F, static_cast<GLsizei>(width), layers, 0, GL_RGBA,
+                           GL_FLOAT, nullptr));
+    for (GLsizei layer = 0; layer < layers; ++layer)
+    {
+        const Palette &palette = context.palettes[layer];
+        GL_ASSERT(glTexSubImage2D(GL_TEXTURE_1D_ARRAY, 0, 0, layer, static_cast<GLsizei>(palette.colors.size()), 1,
+                                  GL_RGBA, GL_FLOAT, palette.colors.data()));
+    }
+}
+
+// Second pass : color the iteration field to the window
+void renderColors(const Context &context)
+{
+    const ColorUniforms &u = context.colorUniforms;
+    const Palette &palette = context.palettes[context.paletteIndex];
+    context.colorShader->useProgram();
+    GL_ASSERT(glActiveTexture(GL_TEXTURE0));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_2D, context.fieldTexture));
+    GL_ASSERT(glActiveTexture(GL_TEXTURE1));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_1D_ARRAY, context.paletteTexture));
+    GL_ASSERT(glActiveTexture(GL_TEXTURE2));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_BUFFER, context.cdfTexture));
+    GL_ASSERT(glActiveTexture(GL_TEXTURE0));
+    GL_ASSERT(glUniform1i(u.fieldUniform, 0));
+    GL_ASSERT(glUniform1i(u.palettesUniform, 1));
+    GL_ASSERT(glUniform1ui(u.maxItersUniform, static_cast<GLuint>(context.iters)));
+    GL_ASSERT(glUniform1i(u.paletteIndexUniform, static_cast<GLint>(context.paletteIndex)));
+    GL_ASSERT(glUniform1i(u.paletteSizeUniform, static_cast<GLint>(palette.colors.size())));
+    GL_ASSERT(glUniform1f(u.paletteLogUniform, palette.mapping == PALETTE_LOG ? 1.f : 0.f));
+    GL_ASSERT(glUniform1f(u.palettePeriodUniform, palette.cycle(context.iters)));
+    GL_ASSERT(glUniform1f(u.paletteOffsetUniform, context.paletteOffset));
+    GL_ASSERT(glUniform1i(u.equalizeUniform, context.equalize ? 1 : 0));
+    GL_ASSERT(glUniform1i(u.cdfUniform, 2));
+    GL_ASSERT(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0));
+}
+
+// Pan the field of the current view by (dx, dy) as the viewer does, and compare it to the field rendered from
+// scratch at the new position : the scrolled pixels must have kept exactly their value
+bool checkPannedField(const CpuRenderer &renderer, Context &context, int dx, int dy)
+{
+    if (context.current_shader == SHADER_PERTURBATION)
+    {
+        std::cerr << "The perturbation field is computed again when panning" << std::endl;
+        return false;
+    }
+    IterationField panned;
+    renderer.render(getView(context), context.current_shader, panned);
+    panView(context, dx, dy);
+    const View view = getView(context);
+    panned.scroll(dx, dy);
+    renderer.renderRects(view, context.current_shader, panned,
+                         IterationField::exposedPixels(view.width, view.height, dx, dy));
+
+    IterationField fresh;
+    renderer.render(view, context.current_shader, fresh);
+    uint differences = 0;
+    for (uint n = 0; n < fresh.iters.size(); ++n)
+    {
+        differences += panned.iters[n] != fresh.iters[n] || panned.norms[n] != fresh.norms[n] ? 1 : 0;
+    }
+    std::cout << "Pan by " << dx << " " << dy << " : " << differences << " pixels differ from the field rendered at"
+              << " the new position" << std::endl;
+    return differences == 0;
+}
+
+// Headless rendering on the CPU, for machines without a GPU
+// Usage : mandelbrot-gl --cpu [options]
+// --shader float|floatfloat|double|quadfloat|doubledouble|perturbation|auto : precision of the kernel (default float)
+// --size W H : image size (default 800 800)
+// --center X Y : center of the view (decimal, any number of digits)
+// --scale S : zoom level (any exponent, e.g. 1e-500)
+// --iters N : max number of iterations
+// --load FILE : load view coordinates saved with F5
+// --threads N : number of threads (default one per core)
+// --simd scalar|avx2|avx512 : instruction set of the double kernel (default widest available)
+// --no-shape-check : disable the main cardioid and period-2 bulb test
+// --no-periodicity : disable the orbit cycle detection
+// --no-derivative : disable the attracting cycle detection with the derivative
+// --series-terms N : terms of the perturbation series approximation (default 8, 0 to disable)
+// --no-bla : disable the bilinear approximation of perturbation steps
+// --subdivide : Mariani-Silver subdivision, filling rectangles with a uniform border
+// --subdivide-strict : Mariani-Silver subdivision, only filling rectangles inside the set
+// --palette NAME|FILE : built-in palette (soft, flashy, blueyellow) or palette file (see Palette.hpp)
+// --palette-offset X : palette shift, in cycles
+// --histogram : histogram equalization of the palette over the frame
+// --out FILE : output png (default mbrot_cpu.png)
+// --check-pan DX DY : instead of saving the image, check that panning it by (DX, DY) pixels (right, down) then
+//                     computing the exposed pixels gives exactly the image rendered at the new position
+int renderHeadless(int argc, char **argv)
+{
+    Context &context = g_context;
+    std::string output = "mbrot_cpu.png";
+    uint threads = 0;
+    SimdIsa simd = detectSimdIsa();
+    RenderMode mode = RENDER_FULL;
+    bool equalize = false;
+    bool checkPan = false;
+    int panX = 0;
+    int panY = 0;
+
+    for (int a = 2; a < argc; ++a)
+    {
+        const std::string arg = argv[a];
+        const int remaining = argc - a - 1;
+        if (arg == "--shader" && remaining >= 1)
+        {
+            const std::string name = argv[++a];
+            if (name == "float") { context.current_shader = SHADER_FLOAT; }
+            else if (name == "floatfloat") { context.current_shader = SHADER_FLOATFLOAT; }
+            else if (name == "double") { context.current_shader = SHADER_DOUBLE; }
+            else if (name == "quadfloat") { context.current_shader = SHADER_QUADFLOAT; }
+            else if (name == "doubledouble") { context.current_shader = SHADER_DOUBLEDOUBLE; }
+            else if (name == "perturbation") { context.current_shader = SHADER_PERTURBATION; }
+            else if (name == "auto") { context.autoPrecision = true; }
+            else
+            {
+                std::cerr << "Unknown shader " << name << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "--size" && remaining >= 2)
+        {
+            context.width = std::stoul(argv[++a]);
+            context.height = std::stoul(argv[++a]);
+        }
+        else if (arg == "--center" && remaining >= 2)
+        {
+            context.centerX = BigFixed::fromDecimalString(argv[++a]);
+            context.centerY = BigFixed::fromDecimalString(argv[++a]);
+        }
+        else if (arg == "--scale" && remaining >= 1)
+        {
+            context.scale = FloatExp::fromString(argv[++a]);
+        }
+        else if (arg == "--iters" && remaining >= 1)
+        {
+            context.iters = std::stoul(argv[++a]);
+        }
+        else if (arg == "--load" && remaining >= 1)
+        {
+            load(context, argv[++a]);
+        }
+        else if (arg == "--threads" && remaining >= 1)
+        {
+            threads = std::stoul(argv[++a]);
+        }
+        else if (arg == "--simd" && remaining >= 1)
+        {
+            const std::string name = argv[++a];
+            if (name == "scalar") { simd = SIMD_SCALAR; }
+            else if (name == "avx2") { simd = SIMD_AVX2; }
+            else if (name == "avx512") { simd = SIMD_AVX512; }
+            else
+            {
+                std::cerr << "Unknown instruction set " << name << std::endl;
+                return -1;
+            }
+            if (simd > detectSimdIsa())
+            {
+                std::cerr << name << " is not supported on this machine" << std::endl;
+                return -1;
+            }
+        }
+        else if (arg == "--no-shape-check")
+        {
+            for (uint &features : context.features)
+            {
+                features &= ~FEATURE_SHAPE_CHECK;
+            }
+        }
+        else if (arg == "--no-periodicity")
+        {
+            for (uint &features : context.features)
+            {
+                features &= ~FEATURE_PERIODICITY;
+            }
+        }
+        else if (arg == "--no-derivative")
+        {
+            for (uint &features : context.features)
+            {
+                features &= ~FEATURE_DERIVATIVE;
+            }
+        }
+        else if (arg == "--series-terms" && remaining >= 1)
+        {
+            context.seriesTerms = std::stoul(argv[++a]);
+        }
+        else if (arg == "--no-bla")
+        {
+            context.bilinearApproximation = false;
+        }
+        else if (arg == "--subdivide")
+        {
+            mode = RENDER_SUBDIVIDE;
+        }
+        else if (arg == "--subdivide-strict")
+        {
+            mode = RENDER_SUBDIVIDE_STRICT;
+        }
+        else if (arg == "--palette" && remaining >= 1)
+        {
+            context.paletteIndex = addPalette(context, argv[++a]);
+        }
+        else if (arg == "--palette-offset" && remaining >= 1)
+        {
+            context.paletteOffset = std::stof(argv[++a]);
+        }
+        else if (arg == "--histogram")
+        {
+            equalize = true;
+        }
+        else if (arg == "--out" && remaining >= 1)
+        {
+            output = argv[++a];
+        }
+        else if (arg == "--check-pan" && remaining >= 2)
+        {
+            checkPan = true;
+            panX = std::stoi(argv[++a]);
+            panY = std::stoi(argv[++a]);
+        }
+        else
+        {
+            std::cerr << "Invalid argument " << arg << std::endl;
+            return -1;
+        }
+    }
+
+    if (context.width == 0 || context.height == 0)
+    {
+        std::cerr << "Invalid image size" << std::endl;
+        return -1;
+    }
+    context.ratio = double(context.width) / double(context.height);
+    if (context.autoPrecision)
+    {
+        updateAutoPrecision(context);
+    }
+
+    CpuRenderer renderer(threads);
+    renderer.setSimdIsa(simd);
+    renderer.setRenderMode(mode);
+    if (checkPan)
+    {
+        return checkPannedField(renderer, context, panX, panY) ? 0 : 1;
+    }
+    const View view = getView(context);
+
+    const auto start = ns_clock::now();
+    IterationField field;
+    renderer.render(view, context.current_shader, field);
+    const Palette &palette = context.palettes[context.paletteIndex];
+    const std::vector<uchar> pixels = equalize ? renderer.colorizeEqualized(field, palette, context.paletteOffset)
+                                               : renderer.colorize(field, palette, context.paletteOffset);
+    const auto end = ns_clock::now();
+
+    const uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::cout << output << ": " << us / 1000.0 << " ms on " << renderer.getThreadCount() << " threads ("
+              << simdIsaName(renderer.getSimdIsa()) << ")" << std::endl;
+    if (field.skippedIters > 0)
+    {
+        std::cout << field.skippedIters << " iterations skipped by the series approximation" << std::endl;
+    }
+    if (field.glitchReferences > 0)
+    {
+        std::cout << field.glitchReferences << " secondary references to fix glitches" << std::endl;
+    }
+    if (field.unfixedGlitches > 0)
+    {
+        std::cout << field.unfixedGlitches << " glitched pixels left unfixed" << std::endl;
+    }
+
+    save_frame(output, pixels, view.width, view.height);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    addPalette(g_context, BUILTIN_PALETTES[0]); // the default palette is the first one
+    if (argc > 1 && std::strcmp(argv[1], "--cpu") == 0)
+    {
+        return renderHeadless(argc, argv);
+    }
+    // mandelbrot-gl --palette NAME|FILE : start with another palette than the default
+    if (argc > 2 && std::strcmp(argv[1], "--palette") == 0)
+    {
+        g_context.paletteIndex = addPalette(g_context, argv[2]);
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -326,17 +1207,77 @@ int main()
     g_context.shaders[SHADER_DOUBLE].reset(new ShaderProgram());
     g_context.shaders[SHADER_DOUBLE]->loadShaderFiles("Vertex.glsl", "PixelD.glsl");
 
+    g_context.shaders[SHADER_QUADFLOAT].reset(new ShaderProgram());
+    g_context.shaders[SHADER_QUADFLOAT]->loadShaderFiles("Vertex.glsl", "PixelQF.glsl");
+
+    g_context.colorShader.reset(new ShaderProgram());
+    g_context.colorShader->loadShaderFiles("Vertex.glsl", "Color.glsl");
+
+    g_context.reprojectShader.reset(new ShaderProgram());
+    g_context.reprojectShader->loadShaderFiles("Vertex.glsl", "Reproject.glsl");
+
     // Initialize each shaders' uniform handles
     for (uint i = 0; i < MAX_SHADERS; ++i)
     {
+        if (!g_context.shaders[i])
+        {
+            continue;
+        }
         Uniforms &u = g_context.uniforms[i];
         const GLint id = g_context.shaders[i]->getID();
         GL_ASSERT(u.centerUniform = glGetUniformLocation(id, "center"));
         GL_ASSERT(u.scaleUniform = glGetUniformLocation(id, "scale"));
-        GL_ASSERT(u.ratioUniform = glGetUniformLocation(id, "ratio"));
+        GL_ASSERT(u.pixelUniform = glGetUniformLocation(id, "pixel"));
+        GL_ASSERT(u.offsetUniform = glGetUniformLocation(id, "offset"));
+        GL_ASSERT(u.maxItersUniform = glGetUniformLocation(id, "max"));
+        GL_ASSERT(u.featuresUniform = glGetUniformLocation(id, "features"));
+    }
+    {
+        ColorUniforms &u = g_context.colorUniforms;
+        const GLint id = g_context.colorShader->getID();
+        GL_ASSERT(u.fieldUniform = glGetUniformLocation(id, "field"));
         GL_ASSERT(u.maxItersUniform = glGetUniformLocation(id, "max"));
+        GL_ASSERT(u.palettesUniform = glGetUniformLocation(id, "palettes"));
+        GL_ASSERT(u.paletteIndexUniform = glGetUniformLocation(id, "paletteIndex"));
+        GL_ASSERT(u.paletteSizeUniform = glGetUniformLocation(id, "paletteSize"));
+        GL_ASSERT(u.paletteLogUniform = glGetUniformLocation(id, "paletteLog"));
+        GL_ASSERT(u.palettePeriodUniform = glGetUniformLocation(id, "palettePeriod"));
+        GL_ASSERT(u.paletteOffsetUniform = glGetUniformLocation(id, "paletteOffset"));
+        GL_ASSERT(u.equalizeUniform = glGetUniformLocation(id, "equalize"));
+        GL_ASSERT(u.cdfUniform = glGetUniformLocation(id, "cdf"));
     }
 
+    // Renderer of the CPU shaders
+    g_context.cpuRenderer.reset(new CpuRenderer());
+
+    // Iteration field, rendered to by the GL shaders
+    GL_ASSERT(glGenTextures(1, &g_context.fieldTexture));
+    GL_ASSERT(glGenTextures(1, &g_context.scrollTexture));
+    for (GLuint texture : {g_context.fieldTexture, g_context.scrollTexture})
+    {
+        GL_ASSERT(glBindTexture(GL_TEXTURE_2D, texture));
+        GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+        GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    }
+    resizeField(g_context);
+    GL_ASSERT(glGenFramebuffers(1, &g_context.fieldFramebuffer));
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, g_context.fieldFramebuffer));
+    GL_ASSERT(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_context.fieldTexture, 0));
+    CORE_ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Incomplete field framebuffer");
+    GL_ASSERT(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GL_ASSERT(glGenQueries(1, &g_context.refineQuery));
+
+    // Palettes, interpolated by the coloring pass itself (as on the CPU)
+    GL_ASSERT(glGenTextures(1, &g_context.paletteTexture));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_1D_ARRAY, g_context.paletteTexture));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    updatePaletteTexture(g_context);
+
+    // Cumulative histogram of the field, filled by updateEqualization()
+    GL_ASSERT(glGenBuffers(1, &g_context.cdfBuffer));
+    GL_ASSERT(glGenTextures(1, &g_context.cdfTexture));
+
     // Set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
     const float vertices[] = {
@@ -379,14 +1320,28 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // select current shader
-        g_context.shaders[g_context.current_shader]->useProgram();
-        updateUniforms(g_context);
+        // select current shader, and compute the iteration field if the view changed
+        if (g_context.autoPrecision)
+        {
+            updateAutoPrecision(g_context);
+        }
+        if (g_context.fieldDirty)
+        {
+            renderField(g_context);
+        }
+        else if (!g_context.refineTiles.empty() || g_context.cpuRefining)
+        {
+            refineField(g_context);
+        }
+        if (g_context.equalize && g_context.cdfDirty)
+        {
+            updateEqualization(g_context);
+        }
 
         update = std::chrono::high_resolution_clock::now();
 
         // draw
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        renderColors(g_context);
 
         render = std::chrono::high_resolution_clock::now();
 
@@ -420,8 +1375,16 @@ int main()
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
+    stopCpuRefinement(g_context);
+    glDeleteQueries(1, &g_context.refineQuery);
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteFramebuffers(1, &g_context.fieldFramebuffer);
+    glDeleteTextures(1, &g_context.fieldTexture);
+    glDeleteTextures(1, &g_context.scrollTexture);
+    glDeleteTextures(1, &g_context.paletteTexture);
+    glDeleteTextures(1, &g_context.cdfTexture);
+    glDeleteBuffers(1, &g_context.cdfBuffer);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -437,25 +1400,41 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    stopCpuRefinement(g_context); // while the field still has the previous size
     g_context.ratio = float(width) / float(height);
     g_context.width = width;
     g_context.height = height;
+    resizeField(g_context);
+    invalidateField(g_context);
 }
 
 // Keyboard controls
 // ESC : quit
-// Arrow keys : move view
-// Z / X : zoom + / zoom -
+// Arrow keys : move view, by whole pixels (only the exposed strips of the field are computed)
+// Z / X : zoom + / zoom - (previewed from the previous field, then computed again over the next frames)
 // I/ J : increase / decrease iterations
 // P : print current view coordinates
 // S : cycle shaders
+// A : toggle the automatic choice of the shader from the zoom level
+// C : toggle the main cardioid / period-2 bulb test of the current shader
+// O : toggle the orbit periodicity detection of the current shader
+// D : toggle the derivative interior detection of the current shader
+// K : cycle palettes
+// [ / ] : scroll the palette
+// H : toggle histogram equalization of the palette
 // F5 : save current view coordinates
 // F9 : load saved coordinates
 void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
     const float sensitivity = 100.f; // Input sensitivity.
+    // Pan step, about scale / sensitivity snapped to whole pixels so that the field can be scrolled
+    const int panStep = std::max(1, int(std::lround(g_context.height / (2.f * sensitivity))));
+    const float paletteStep = 1.f / 64.f; // Palette shift per key press, in cycles
     if (action == GLFW_PRESS || action == GLFW_REPEAT)
     {
+        // The field is only computed again for keys that change the view. Pans and zooms reuse it (see
+        // renderField()), and the other keys only affect the coloring pass or nothing at all.
+        bool viewChanged = false;
         switch (key)
         {
         case GLFW_KEY_ESCAPE:
@@ -465,51 +1444,55 @@ void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, in
         }
         case GLFW_KEY_UP:
         {
-            g_context.centerY += (g_context.scale / sensitivity);
+            panView(g_context, 0, -panStep);
             break;
         }
         case GLFW_KEY_DOWN:
         {
-            g_context.centerY -= (g_context.scale / sensitivity);
+            panView(g_context, 0, panStep);
             break;
         }
         case GLFW_KEY_RIGHT:
         {
-            g_context.centerX += (g_context.scale / sensitivity);
+            panView(g_context, panStep, 0);
             break;
         }
         case GLFW_KEY_LEFT:
         {
-            g_context.centerX -= (g_context.scale / sensitivity);
+            panView(g_context, -panStep, 0);
             break;
         }
         case GLFW_KEY_Z:
         {
-            g_context.scale *= (1.0f - 1 / sensitivity);
+            zoomView(g_context, 1.0f - 1 / sensitivity);
             break;
         }
         case GLFW_KEY_X:
         {
-            g_context.scale *= (1.0f + 1 / sensitivity);
+            zoomView(g_context, 1.0f + 1 / sensitivity);
             break;
         }
         case GLFW_KEY_I:
         {
             g_context.iters = std::min(100000u, g_context.iters * 10);
+            viewChanged = true;
             break;
         }
         case GLFW_KEY_J:
         {
             g_context.iters = std::max(1u, g_context.iters / 10);
+            viewChanged = true;
             break;
         }
         case GLFW_KEY_P:
         {
             if (action == GLFW_PRESS)
             {
-                std::cout << g_context.centerX << " "
-                          << g_context.centerY << " "
-                          << g_context.scale
+                // Enough digits to locate the center within a pixel
+                const uint digits = uint(std::max(0.0, -g_context.scale.log10())) + 6;
+                std::cout << imageCenterX(g_context).toDecimalString(digits) << " "
+                          << imageCenterY(g_context).toDecimalString(digits) << " "
+                          << g_context.scale.toString()
                           << "(" << g_context.iters << ")" << std::endl;
             }
             break;
@@ -520,7 +1503,61 @@ void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, in
             {
                 g_context.current_shader = ShaderType((g_context.current_shader + 1) % MAX_SHADERS);
                 std::cout << " switching to shader" << g_context.current_shader << std::endl;
+                if (g_context.autoPrecision)
+                {
+                    g_context.autoPrecision = false;
+                    std::cout << " auto precision off" << std::endl;
+                }
+                g_monitor.reset();
+                viewChanged = true;
+            }
+            break;
+        }
+        case GLFW_KEY_A:
+        {
+            if (action == GLFW_PRESS)
+            {
+                g_context.autoPrecision = !g_context.autoPrecision;
+                std::cout << " auto precision " << (g_context.autoPrecision ? "on" : "off") << std::endl;
+            }
+            break;
+        }
+        case GLFW_KEY_C:
+        {
+            if (action == GLFW_PRESS)
+            {
+                uint &features = g_context.features[g_context.current_shader];
+                features ^= FEATURE_SHAPE_CHECK;
+                std::cout << " shape check " << ((features & FEATURE_SHAPE_CHECK) ? "on" : "off")
+                          << " for shader " << g_context.current_shader << std::endl;
+                g_monitor.reset();
+                viewChanged = true;
+            }
+            break;
+        }
+        case GLFW_KEY_O:
+        {
+            if (action == GLFW_PRESS)
+            {
+                uint &features = g_context.features[g_context.current_shader];
+                features ^= FEATURE_PERIODICITY;
+                std::cout << " periodicity detection " << ((features & FEATURE_PERIODICITY) ? "on" : "off")
+                          << " for shader " << g_context.current_shader << std::endl;
                 g_monitor.reset();
+                viewChanged = true;
+            }
+            break;
+        }
+        case GLFW_KEY_D:
+        {
+            if (action == GLFW_PRESS)
+            {
+                uint &features = g_context.features[g_context.current_shader];
+                features ^= FEATURE_DERIVATIVE;
+                std::cout << " derivative detection " << ((features & FEATURE_DERIVATIVE) ? "on" : "off")
+                          << " for shader " << g_context.current_shader << std::endl;
+                g_monitor.reset();
+                viewChanged = true;
             }
             break;
         }
@@ -532,13 +1569,45 @@ void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, in
         case GLFW_KEY_F9:
         {
             load(g_context, "mbrot.sav");
+            viewChanged = true;
             break;
         }
         case GLFW_KEY_F12:
         {
             g_context.screenshot = true;
+            break;
+        }
+        case GLFW_KEY_K:
+        {
+            if (action == GLFW_PRESS)
+            {
+                g_context.paletteIndex = (g_context.paletteIndex + 1) % g_context.palettes.size();
+                std::cout << " switching to palette " << g_context.palettes[g_context.paletteIndex].name << std::endl;
+            }
+            break;
+        }
+        case GLFW_KEY_H:
+        {
+            if (action == GLFW_PRESS)
+            {
+                g_context.equalize = !g_context.equalize;
+                std::cout << " histogram equalization " << (g_context.equalize ? "on" : "off") << std::endl;
+            }
+            break;
+        }
+        case GLFW_KEY_LEFT_BRACKET:
+        case GLFW_KEY_RIGHT_BRACKET:
+        {
+            g_context.paletteOffset += key == GLFW_KEY_RIGHT_BRACKET ? paletteStep : -paletteStep;
+            g_context.paletteOffset -= std::floor(g_context.paletteOffset);
+            break;
         }
 
         } // switch
+
+        if (viewChanged)
+        {
+            invalidateField(g_context);
+        }
     }     // if (pressed)
 }
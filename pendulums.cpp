@@ -13,6 +13,8 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
+#include "TileScheduler.hpp"
+
 // Decide on floating point type
 #define USE_DOUBLE
 #ifdef USE_DOUBLE
@@ -201,26 +203,18 @@ struct Image
             simulate(sim, i);
         }
 #else
-        const uint thread_count = std::thread::hardware_concurrency();
-        std::vector<std::thread> threads;
-        threads.reserve(thread_count);
-
-        for (uint t = 0; t < thread_count; ++t)
-        {
-            threads.emplace_back(
-                [sim, this, t, thread_count] {
-                    const int start = pixel_count * t / thread_count;
-                    const int stop = std::min<int>(pixel_count, pixel_count * (t + 1) / thread_count);
-                    for (int i = start; i < stop; ++i)
-                    {
-                        simulate(sim, i);
-                    }
-                });
-        }
-        for (auto &t : threads)
-        {
-            t.join();
-        }
+        // Simulation time varies a lot between pixels : balance the work by stealing
+        // small chunks of pixels (one image column each) between threads.
+        TileScheduler scheduler;
+        const uint thread_count = scheduler.getThreadCount();
+        scheduler.run(N, [sim, this](uint chunk) {
+            const int start = chunk * N;
+            const int stop = start + N;
+            for (int i = start; i < stop; ++i)
+            {
+                simulate(sim, i);
+            }
+        });
 #endif
         const auto end = std::chrono::high_resolution_clock::now();
         const uint64 us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();